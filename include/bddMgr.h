@@ -0,0 +1 @@
+../src/bdd/bddMgr.h
\ No newline at end of file
@@ -0,0 +1 @@
+bddMgr.o: bddMgr.cpp bddMgr.h ../../include/myHashMap.h
@@ -0,0 +1,4 @@
+bdd.d: ../../include/bddMgr.h 
+../../include/bddMgr.h: bddMgr.h
+	@rm -f ../../include/bddMgr.h
+	@ln -fs ../src/bdd/bddMgr.h ../../include/bddMgr.h
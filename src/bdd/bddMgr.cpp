@@ -0,0 +1,136 @@
+/****************************************************************************
+  FileName     [ bddMgr.cpp ]
+  PackageName  [ bdd ]
+  Synopsis     [ Define BDD manager functions ]
+  Copyright    [ Copyleft(c) 2012-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "bddMgr.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const size_t bddCacheSize = (size_t)1 << 16;
+
+/**************************************/
+/*   class BddMgr member functions    */
+/**************************************/
+BddMgr::BddMgr(unsigned nVars, size_t maxNodes)
+   : _nVars(nVars), _maxNodes(maxNodes), _andCache(bddCacheSize)
+{
+   size_t n = 1;
+   while (n < maxNodes) n <<= 1;
+   _unique.assign(n, 0);
+   BddNode one = { nVars, BDD_ONE, BDD_ONE, 1, 0 };
+   _nodes.push_back(one);
+}
+
+Bdd
+BddMgr::ithVar(unsigned i)
+{
+   assert(i < _nVars);
+   return mkNode(i, BDD_ONE, BDD_ZERO);
+}
+
+Bdd
+BddMgr::bddAnd(Bdd f, Bdd g)
+{
+   if (f == BDD_FAIL || g == BDD_FAIL) return BDD_FAIL;
+   return andRec(f, g);
+}
+
+// Free every node no longer referenced; the freed nodes release their
+// children in turn. The unique table is then rebuilt from the live nodes,
+// and the computed cache may point at freed ones, so it goes too.
+void
+BddMgr::gc()
+{
+   vector<unsigned> dead;
+   for (unsigned i = 1, n = _nodes.size(); i < n; ++i)
+      if (_nodes[i]._ref == 0 && _nodes[i]._var != _nVars)
+         dead.push_back(i);
+   while (!dead.empty()) {
+      unsigned i = dead.back();
+      dead.pop_back();
+      BddNode& x = _nodes[i];
+      Bdd c[2] = { x._then, x._else };
+      for (int j = 0; j < 2; ++j)
+         if (--_nodes[c[j] >> 1]._ref == 0 && (c[j] >> 1) != 0)
+            dead.push_back(c[j] >> 1);
+      x._var = _nVars;        // marks a free node
+      _freeList.push_back(i);
+   }
+   fill(_unique.begin(), _unique.end(), 0);
+   for (unsigned i = 1, n = _nodes.size(); i < n; ++i) {
+      BddNode& x = _nodes[i];
+      if (x._var == _nVars) continue;
+      size_t h = uniqueSlot(x._var, x._then, x._else);
+      x._next = _unique[h];
+      _unique[h] = i;
+   }
+   _andCache.init(bddCacheSize);
+}
+
+/**************************************/
+/*   Private member functions         */
+/**************************************/
+Bdd
+BddMgr::mkNode(unsigned v, Bdd t, Bdd e)
+{
+   if (t == BDD_FAIL || e == BDD_FAIL) return BDD_FAIL;
+   if (t == e) return t;
+   if (t & 1) {
+      Bdd r = mkNode(v, t ^ 1, e ^ 1);
+      return (r == BDD_FAIL) ? r : r ^ 1;
+   }
+   size_t h = uniqueSlot(v, t, e);
+   for (unsigned i = _unique[h]; i; i = _nodes[i]._next) {
+      const BddNode& x = _nodes[i];
+      if (x._var == v && x._then == t && x._else == e) return i << 1;
+   }
+   if (numNodes() >= _maxNodes) return BDD_FAIL;
+
+   unsigned id;
+   BddNode x = { v, t, e, 0, _unique[h] };
+   if (_freeList.empty()) {
+      id = _nodes.size();
+      _nodes.push_back(x);
+   }
+   else {
+      id = _freeList.back();
+      _freeList.pop_back();
+      _nodes[id] = x;
+   }
+   ++_nodes[t >> 1]._ref;
+   ++_nodes[e >> 1]._ref;
+   _unique[h] = id;
+   return id << 1;
+}
+
+Bdd
+BddMgr::andRec(Bdd f, Bdd g)
+{
+   if (f == BDD_ZERO || g == BDD_ZERO || f == (g ^ 1)) return BDD_ZERO;
+   if (f == BDD_ONE || f == g) return g;
+   if (g == BDD_ONE) return f;
+   if (f > g) { Bdd t = f; f = g; g = t; }
+
+   BddCKey key(f, g);
+   Bdd r;
+   if (_andCache.read(key, r)) return r;
+   unsigned vf = topVar(f), vg = topVar(g);
+   unsigned v = (vf < vg) ? vf : vg;
+   Bdd f1 = (vf == v) ? thenOf(f) : f, f0 = (vf == v) ? elseOf(f) : f;
+   Bdd g1 = (vg == v) ? thenOf(g) : g, g0 = (vg == v) ? elseOf(g) : g;
+   Bdd t = andRec(f1, g1);
+   if (t == BDD_FAIL) return t;
+   Bdd e = andRec(f0, g0);
+   if (e == BDD_FAIL) return e;
+   r = mkNode(v, t, e);
+   if (r != BDD_FAIL) _andCache.write(key, r);
+   return r;
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+  FileName     [ bddMgr.h ]
+  PackageName  [ bdd ]
+  Synopsis     [ Define a lightweight ROBDD manager ]
+  Copyright    [ Copyleft(c) 2012-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef BDD_MGR_H
+#define BDD_MGR_H
+
+#include <vector>
+#include "myHashMap.h"
+
+using namespace std;
+
+// A BDD is an edge: (node index << 1) | complemented. Node 0 is the
+// terminal, so BDD_ONE == 0 and BDD_ZERO == 1. Then-edges are never
+// complemented, which keeps the graph canonical.
+typedef unsigned Bdd;
+
+const Bdd BDD_ONE  = 0;
+const Bdd BDD_ZERO = 1;
+const Bdd BDD_FAIL = ~0u;      // the node limit was hit
+
+class BddCKey
+{
+public:
+   BddCKey(Bdd f = 0, Bdd g = 0) : _f(f), _g(g) {}
+   size_t operator () () const { return (size_t)_f * 1610612741 + _g; }
+   bool operator == (const BddCKey& k) const { return _f == k._f && _g == k._g; }
+private:
+   Bdd _f;
+   Bdd _g;
+};
+
+class BddMgr
+{
+   struct BddNode {
+      unsigned _var;          // level; the terminal is below all variables
+      Bdd      _then;
+      Bdd      _else;
+      unsigned _ref;          // parent nodes + external references
+      unsigned _next;         // unique table chain (0: end)
+   };
+
+public:
+   // Variables are 0 .. nVars-1, variable 0 on top. At most "maxNodes"
+   // nodes are alive at a time; an operation that needs more returns
+   // BDD_FAIL and leaves the manager usable.
+   BddMgr(unsigned nVars, size_t maxNodes);
+   ~BddMgr() {}
+
+   Bdd ithVar(unsigned i);
+   Bdd bddAnd(Bdd f, Bdd g);
+   static Bdd bddNot(Bdd f) { return f ^ 1; }
+
+   // Results of the operations must be ref'ed to survive garbage collection
+   void ref(Bdd f) { if (f != BDD_FAIL) ++_nodes[f >> 1]._ref; }
+   void deref(Bdd f) { if (f != BDD_FAIL) --_nodes[f >> 1]._ref; }
+   void gc();
+
+   unsigned nVars() const { return _nVars; }
+   size_t numNodes() const { return _nodes.size() - _freeList.size(); }
+
+private:
+   unsigned                 _nVars;
+   size_t                   _maxNodes;
+   vector<BddNode>          _nodes;
+   vector<unsigned>         _freeList;
+   vector<unsigned>         _unique;    // chain heads, a power of 2
+   Cache<BddCKey, Bdd>      _andCache;
+
+   unsigned topVar(Bdd f) const { return _nodes[f >> 1]._var; }
+   Bdd thenOf(Bdd f) const { return _nodes[f >> 1]._then ^ (f & 1); }
+   Bdd elseOf(Bdd f) const { return _nodes[f >> 1]._else ^ (f & 1); }
+   size_t uniqueSlot(unsigned v, Bdd t, Bdd e) const {
+      return (((size_t)t * 12582917 + e) * 4256249 + v) & (_unique.size() - 1); }
+   Bdd mkNode(unsigned v, Bdd t, Bdd e);
+   Bdd andRec(Bdd f, Bdd g);
+};
+
+#endif // BDD_MGR_H
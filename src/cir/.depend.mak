@@ -19,7 +19,8 @@ cirFraig.o: cirFraig.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
  cirGate.h ../../include/sat.h ../../include/Solver.h \
  ../../include/SolverTypes.h ../../include/Global.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
- ../../include/File.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/File.h ../../include/bddMgr.h ../../include/util.h \
+ ../../include/rnGen.h \
  ../../include/myUsage.h
 cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
  cirGate.h ../../include/sat.h ../../include/Solver.h \
@@ -34,3 +35,9 @@ cirOpt.o: cirOpt.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
  ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
  ../../include/File.h ../../include/util.h ../../include/rnGen.h \
  ../../include/myUsage.h
+cirCec.o: cirCec.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
+ cirGate.h ../../include/sat.h ../../include/Solver.h \
+ ../../include/SolverTypes.h ../../include/Global.h \
+ ../../include/VarOrder.h ../../include/Heap.h ../../include/Proof.h \
+ ../../include/File.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
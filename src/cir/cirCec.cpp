@@ -0,0 +1,220 @@
+/****************************************************************************
+  FileName     [ cirCec.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define combinational equivalence checking functions ]
+  Copyright    [ Copyleft(c) 2012-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <map>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "sat.h"
+#include "util.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Index in "ref" of each name in "names"; the names in "ref" must all
+// exist and be unique
+static bool
+matchByName(const vector<string>& ref, const vector<string>& names,
+            const string& kind, vector<unsigned>& idx)
+{
+  map<string, unsigned> at;
+  for (unsigned i = 0, n = ref.size(); i < n; ++i) {
+    if (ref[i].empty() || !at.insert(make_pair(ref[i], i)).second) {
+      cerr << "Error: " << kind << " " << i << " of the first circuit has no unique name!!" << endl;
+      return false;
+    }
+  }
+  idx.resize(names.size());
+  for (unsigned i = 0, n = names.size(); i < n; ++i) {
+    map<string, unsigned>::iterator it = at.find(names[i]);
+    if (it == at.end()) {
+      cerr << "Error: " << kind << " \"" << names[i] << "\" of the second circuit has no match!!" << endl;
+      return false;
+    }
+    idx[i] = it->second;
+    at.erase(it);
+  }
+  return true;
+}
+
+/*****************************************/
+/*   Public member functions about CEC   */
+/*****************************************/
+// Build the miter of two circuits in this (empty) manager: the PIs are
+// shared and the POs of the first circuit are followed by those of the
+// second, so PO pair i is (po(i), po(n + i)). PIs and POs are matched by
+// order, or by symbol name if "byName". Undefined gates become constant 0
+// as in simulation.
+bool
+CirMgr::readMiter(const string& file1, const string& file2, bool byName)
+{
+  // the parser checks the header through the global manager
+  CirMgr* c[2] = { new CirMgr, new CirMgr };
+  CirMgr* saved = cirMgr;
+  bool ok = (cirMgr = c[0])->readCircuit(file1) &&
+            (cirMgr = c[1])->readCircuit(file2);
+  cirMgr = saved;
+  if (ok && (c[0]->_nPI != c[1]->_nPI || c[0]->_nPO != c[1]->_nPO)) {
+    cerr << "Error: the circuits have different numbers of PIs or POs!!" << endl;
+    ok = false;
+  }
+  if (ok) ok = buildMiter(c, byName);
+  delete c[0];
+  delete c[1];
+  return ok;
+}
+
+bool
+CirMgr::buildMiter(CirMgr* c[2], bool byName)
+{
+  unsigned nPI = c[0]->_nPI, nPO = c[0]->_nPO;
+  vector<unsigned> piOf(nPI), poOf(nPO);
+  if (byName) {
+    vector<string> ref, names;
+    for (unsigned i = 0; i < nPI; ++i) {
+      ref.push_back(c[0]->pi(i)->symbol());
+      names.push_back(c[1]->pi(i)->symbol());
+    }
+    if (!matchByName(ref, names, "PI", piOf)) return false;
+    ref.clear(); names.clear();
+    for (unsigned i = 0; i < nPO; ++i) {
+      ref.push_back(c[0]->po(i)->symbol());
+      names.push_back(c[1]->po(i)->symbol());
+    }
+    if (!matchByName(ref, names, "PO", poOf)) return false;
+  }
+  else {
+    for (unsigned i = 0; i < nPI; ++i) piOf[i] = i;
+    for (unsigned i = 0; i < nPO; ++i) poOf[i] = i;
+  }
+
+  _nPI = nPI;
+  _nPO = 2 * nPO;
+  _nLATCH = 0;
+  _maxIdx = nPI + c[0]->_nDfsAIG + c[1]->_nDfsAIG;
+  preProcess();
+  for (unsigned i = 0; i < nPI; ++i) {
+    CirPiGate* g = new CirPiGate(0, i + 1);
+    g->setMgr(this);
+    g->setSymbol(c[0]->pi(i)->symbol());
+    _vAllGates[i + 1] = g;
+    _vPi.push_back(g);
+  }
+  unsigned var = nPI + 1;
+  for (int k = 0; k < 2; ++k) {
+    vector<CirGate*> copyOf(c[k]->_vAllGates.size(), _vAllGates[0]);
+    for (unsigned i = 0; i < nPI; ++i)
+      copyOf[c[k]->pi(i)->getVar()] = _vPi[k ? piOf[i] : i];
+    for (size_t i = 0, n = c[k]->_vDfsList.size(); i < n; ++i) {
+      CirGate* g = c[k]->_vDfsList[i];
+      if (!g->isAig()) continue;
+      CirAigGate* x = new CirAigGate(0, var++);
+      x->setMgr(this);
+      CirGate *in0 = copyOf[g->fanin0_var()], *in1 = copyOf[g->fanin1_var()];
+      x->setFanin0(in0, g->fanin0_inv());
+      x->setFanin1(in1, g->fanin1_inv());
+      in0->addFanout(x, g->fanin0_inv());
+      in1->addFanout(x, g->fanin1_inv());
+      _vAllGates[x->getVar()] = copyOf[g->getVar()] = x;
+    }
+    for (unsigned i = 0; i < nPO; ++i) {
+      CirPoGate* p = c[k]->po(i);
+      unsigned id = k ? nPO + poOf[i] : i;
+      CirPoGate* x = new CirPoGate(0, _maxIdx + 1 + id);
+      x->setMgr(this);
+      CirGate* in = copyOf[p->fanin0_var()];
+      x->setFanin0(in, p->fanin0_inv());
+      in->addFanout(x, p->fanin0_inv());
+      x->setSymbol(p->symbol());
+      _vAllGates[_maxIdx + 1 + id] = x;
+    }
+  }
+
+  buildDfsList();
+  buildFloatingList();
+  buildUnusedList();
+  buildUndefList();
+  countAig();
+  sortAllGateFanout();
+  strash_check = false;
+  return true;
+}
+
+// Prove the PO pairs of the miter. Random simulation splits most of the
+// differing pairs; if any pair survives it, fraig (cheap pairs first, BDDs
+// where they stay small) merges the internal equivalences of the two
+// circuits, which usually merges the PO pairs too. What is left is decided
+// by SAT on the reduced miter, with a counterexample over the PIs (in the
+// order of the first circuit) for each failing pair. With "elim", the
+// proof model is preprocessed first: the internal AND nodes are eliminated
+// where that shrinks the CNF, keeping the PIs and the pair outputs.
+// Return true if all the pairs are equivalent.
+bool
+CirMgr::cec(bool elim)
+{
+  unsigned nPair = _nPO / 2;
+  streambuf* out = cout.rdbuf(0);     // the sweep is internal; keep it quiet
+  randomSim();
+  // a pair split by simulation is refuted by an easy SAT call below; the
+  // sweep only pays off if some pair is still an FEC candidate
+  bool sweep = false;
+  for (unsigned i = 0; i < nPair && !sweep; ++i) {
+    CirGateV a = po(i)->fanin0(), b = po(nPair + i)->fanin0();
+    sweep = a.gate()->getFec() && a.gate()->getFec() == b.gate()->getFec() &&
+            (a.isInv() ^ a.gate()->getFecInv()) == (b.isInv() ^ b.gate()->getFecInv());
+  }
+  if (sweep) fraig(FRAIG_SIZE, FRAIG_AUTO);
+  cout.rdbuf(out);
+  cout.clear();
+
+  SatSolver solver;
+  solver.initialize();
+  solver.setPortfolio(_satThreads);
+  solver.setSearchMode(restart_Luby, true);
+  solver.setPhaseSaving(true);
+  genProofModel(solver);
+  if (elim) {
+    // (the PO var is its fanin's)
+    solver.freeze(_vAllGates[0]->getSatVar());
+    for (unsigned i = 0; i < _nPI; ++i)
+      solver.freeze(pi(i)->getSatVar());
+    for (unsigned i = 0; i < _nPO; ++i)
+      solver.freeze(po(i)->getSatVar());
+    solver.eliminate();
+  }
+  unsigned nDiff = 0;
+  for (unsigned i = 0; i < nPair; ++i) {
+    CirGateV a = po(i)->fanin0(), b = po(nPair + i)->fanin0();
+    string name = po(i)->symbol().empty() ? "" : " (" + po(i)->symbol() + ")";
+    cout << "PO " << i << name << ": ";
+    bool equal = (a == b);
+    if (!equal) {
+      Var v = solver.newVar();
+      solver.addXorCNF(v, a.gate()->getSatVar(), a.isInv(), b.gate()->getSatVar(), b.isInv());
+      solver.assumeRelease();
+      solver.assumeProperty(v, true);
+      equal = !solver.assumpSolve();
+      if (equal) solver.assertProperty(v, false);
+    }
+    if (equal) {
+      cout << "equivalent" << endl;
+      continue;
+    }
+    ++nDiff;
+    cout << "NOT equivalent; counterexample ";
+    for (unsigned j = 0; j < _nPI; ++j)
+      cout << (solver.getValue(pi(j)->getSatVar()) == 1 ? '1' : '0');
+    cout << endl;
+  }
+  if (nDiff == 0)
+    cout << "Circuits are equivalent!!" << endl;
+  else
+    cout << "Circuits are NOT equivalent (" << nDiff << " of " << nPair
+         << " PO pairs differ)!!" << endl;
+  return nDiff == 0;
+}
@@ -7,6 +7,7 @@
 ****************************************************************************/
 
 #include <cassert>
+#include <cstdio>
 #include <iostream>
 #include <iomanip>
 #include "cirMgr.h"
@@ -29,7 +30,9 @@ initCirCmd()
          cmdMgr->regCmd("CIROPTimize", 6, new CirOptCmd) &&
          cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
          cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
+         cmdMgr->regCmd("CIRPATtern", 6, new CirPatternCmd) &&
          cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd) &&
+         cmdMgr->regCmd("CIRCEC", 6, new CirCecCmd) &&
          cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
@@ -374,8 +377,11 @@ CirStrashCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRSIMulate <-Random | -File <string patternFile>>
-//                [-Output (string logFile)]
+//    CIRSIMulate <-Random [-Seed (size_t seed)]
+//                 [-Weight (string weightFile) | -SIGprob | -FLip]
+//                | -File <string patternFile>>
+//                [-Output (string logFile) [-Binary]] [-Threads (int n)]
+//                [-Compile] [-Accumulate]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirSimCmd::exec(const string& option)
@@ -388,9 +394,15 @@ CirSimCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   ifstream patternFile;
+   ifstream patternFile, weightFile;
    ofstream logFile;
-   bool doRandom = false, doFile = false, doLog = false;
+   string patternName;
+   SimPatGen gen = SIM_UNIFORM;
+   string genOpt;
+   bool doRandom = false, doFile = false, doLog = false, doBinLog = false;
+   bool doSeed = false, doThread = false, doCompile = false, doAccum = false;
+   size_t seed = 0;
+   int nThread = 1;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Random", options[i], 2) == 0) {
          if (doRandom || doFile)
@@ -405,6 +417,7 @@ CirSimCmd::exec(const string& option)
          patternFile.open(options[i].c_str(), ios::in);
          if (!patternFile)
             return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         patternName = options[i];
          doFile = true;
       }
       else if (myStrNCmp("-Output", options[i], 2) == 0) {
@@ -412,25 +425,101 @@ CirSimCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         logFile.open(options[i].c_str(), ios::out);
+         logFile.open(options[i].c_str(), ios::out | ios::binary);
          if (!logFile)
             return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
          doLog = true;
       }
+      else if (myStrNCmp("-Seed", options[i], 2) == 0) {
+         if (doSeed)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Size(options[i], seed))
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doSeed = true;
+      }
+      else if (myStrNCmp("-Weight", options[i], 2) == 0) {
+         if (gen != SIM_UNIFORM)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         weightFile.open(options[i].c_str(), ios::in);
+         if (!weightFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         gen = SIM_WEIGHT;
+         genOpt = options[i-1];
+      }
+      else if (myStrNCmp("-SIGprob", options[i], 4) == 0) {
+         if (gen != SIM_UNIFORM)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         gen = SIM_SIGPROB;
+         genOpt = options[i];
+      }
+      else if (myStrNCmp("-FLip", options[i], 3) == 0) {
+         if (gen != SIM_UNIFORM)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         gen = SIM_FLIP;
+         genOpt = options[i];
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (doThread)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], nThread) || nThread <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
+      else if (myStrNCmp("-Compile", options[i], 2) == 0) {
+         if (doCompile)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doCompile = true;
+      }
+      else if (myStrNCmp("-Accumulate", options[i], 2) == 0) {
+         if (doAccum)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doAccum = true;
+      }
+      else if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (doBinLog)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBinLog = true;
+      }
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
    if (!doRandom && !doFile)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (doBinLog && !doLog)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "-Output");
+   if (doSeed && !doRandom)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Seed");
+   if (gen != SIM_UNIFORM && !doRandom)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, genOpt);
+   if (gen == SIM_WEIGHT && !cirMgr->readPiWeight(weightFile))
+      return CMD_EXEC_ERROR;
 
    assert (curCmd != CIRINIT);
    if (doLog)
-      cirMgr->setSimLog(&logFile);
+      cirMgr->setSimLog(&logFile, doBinLog);
    else cirMgr->setSimLog(0);
 
+   if (doSeed)
+      cirMgr->setSimSeed(seed);
+   cirMgr->setSimThreads(nThread);
+   cirMgr->setSimCompile(doCompile);
+   cirMgr->setSimAccum(doAccum);
    if (doRandom)
-      cirMgr->randomSim();
+      cirMgr->randomSim(gen);
+   else if (CirMgr::isBinPattern(patternFile)) {
+      patternFile.close();
+      if (!cirMgr->binFileSim(patternName)) {
+         cirMgr->setSimLog(0);
+         return CMD_EXEC_ERROR;
+      }
+   }
    else
       cirMgr->fileSim(patternFile);
    cirMgr->setSimLog(0);
@@ -442,8 +531,11 @@ CirSimCmd::exec(const string& option)
 void
 CirSimCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>\n"
-      << "                   [-Output (string logFile)]" << endl;
+   os << "Usage: CIRSIMulate <-Random [-Seed (size_t seed)]\n"
+      << "                    [-Weight (string weightFile) | -SIGprob | -FLip]\n"
+      << "                   | -File <string patternFile>>\n"
+      << "                   [-Output (string logFile) [-Binary]] [-Threads (int n)]\n"
+      << "                   [-Compile] [-Accumulate]" << endl;
 }
 
 void
@@ -454,7 +546,76 @@ CirSimCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRFraig
+//    CIRPATtern <(string patternFile)> <-Output (string binFile)>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirPatternCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   ifstream patternFile;
+   string binName;
+   bool hasFile = false, hasOutput = false;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (hasOutput)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         binName = options[i];
+         hasOutput = true;
+      }
+      else {
+         if (hasFile)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         patternFile.open(options[i].c_str(), ios::in);
+         if (!patternFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         hasFile = true;
+      }
+   }
+   if (!hasFile || !hasOutput)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   ofstream binFile(binName.c_str(), ios::out | ios::binary);
+   if (!binFile)
+      return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, binName);
+   if (!cirMgr->convertPattern(patternFile, binFile)) {
+      // do not leave a partial file behind
+      binFile.close();
+      remove(binName.c_str());
+      return CMD_EXEC_ERROR;
+   }
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirPatternCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRPATtern <(string patternFile)> <-Output (string binFile)>"
+      << endl;
+}
+
+void
+CirPatternCmd::help() const
+{
+   cout << setw(15) << left << "CIRPATtern: "
+        << "convert a pattern file to the binary pattern format\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRFraig [-Order <List | Size | Depth>] [-Engine <Sat | Bdd | Auto>]
+//             [-Seed <None | Level | Fanout | Simulation>] [-Threads (int n)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirFraigCmd::exec(const string& option)
@@ -467,14 +628,65 @@ CirFraigCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   if (!options.empty())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+   FraigOrder order = FRAIG_LIST;
+   FraigEngine engine = FRAIG_SAT;
+   FraigSeed seed = FRAIG_SEED_NONE;
+   bool doOrder = false, doEngine = false, doSeed = false, doThread = false;
+   int nThread = 1;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Order", options[i], 2) == 0) {
+         if (doOrder)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("List", options[i], 1) == 0) order = FRAIG_LIST;
+         else if (myStrNCmp("Size", options[i], 1) == 0) order = FRAIG_SIZE;
+         else if (myStrNCmp("Depth", options[i], 1) == 0) order = FRAIG_DEPTH;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doOrder = true;
+      }
+      else if (myStrNCmp("-Engine", options[i], 2) == 0) {
+         if (doEngine)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("Sat", options[i], 1) == 0) engine = FRAIG_SAT;
+         else if (myStrNCmp("Bdd", options[i], 1) == 0) engine = FRAIG_BDD;
+         else if (myStrNCmp("Auto", options[i], 1) == 0) engine = FRAIG_AUTO;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doEngine = true;
+      }
+      else if (myStrNCmp("-Seed", options[i], 2) == 0) {
+         if (doSeed)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("None", options[i], 1) == 0) seed = FRAIG_SEED_NONE;
+         else if (myStrNCmp("Level", options[i], 1) == 0) seed = FRAIG_SEED_LEVEL;
+         else if (myStrNCmp("Fanout", options[i], 1) == 0) seed = FRAIG_SEED_FANOUT;
+         else if (myStrNCmp("Simulation", options[i], 1) == 0) seed = FRAIG_SEED_SIM;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doSeed = true;
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (doThread)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], nThread) || nThread <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+   }
 
    if (curCmd != CIRSIMULATE) {
       cerr << "Error: circuit is not yet simulated!!" << endl;
       return CMD_EXEC_ERROR;
    }
-   cirMgr->fraig();
+   cirMgr->setSatThreads(nThread);
+   cirMgr->fraig(order, engine, seed);
    curCmd = CIRFRAIG;
 
    return CMD_EXEC_DONE;
@@ -483,7 +695,8 @@ CirFraigCmd::exec(const string& option)
 void
 CirFraigCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRFraig" << endl;
+   os << "Usage: CIRFraig [-Order <List | Size | Depth>] [-Engine <Sat | Bdd | Auto>]\n"
+      << "                [-Seed <None | Level | Fanout | Simulation>] [-Threads (int n)]" << endl;
 }
 
 void
@@ -493,6 +706,76 @@ CirFraigCmd::help() const
         << "perform Boolean logic simulation on the circuit\n";
 }
 
+//----------------------------------------------------------------------
+//    CIRCEC <(string file1)> <(string file2)> [-Name] [-Eliminate] [-Threads (int n)]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirCecCmd::exec(const string& option)
+{
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   vector<string> files;
+   bool byName = false, elim = false, doThread = false;
+   int nThread = 1;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Name", options[i], 2) == 0) {
+         if (byName)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         byName = true;
+      }
+      else if (myStrNCmp("-Eliminate", options[i], 2) == 0) {
+         if (elim)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         elim = true;
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (doThread)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], nThread) || nThread <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
+      else {
+         if (files.size() == 2)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         files.push_back(options[i]);
+      }
+   }
+   if (files.size() < 2)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   // the miter is a circuit of its own; the current one is left alone
+   CirMgr* miter = new CirMgr;
+   if (!miter->readMiter(files[0], files[1], byName)) {
+      delete miter;
+      return CMD_EXEC_ERROR;
+   }
+   miter->setSatThreads(nThread);
+   miter->cec(elim);
+   delete miter;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirCecCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRCEC <(string file1)> <(string file2)> [-Name] [-Eliminate]\n"
+      << "              [-Threads (int n)]" << endl;
+}
+
+void
+CirCecCmd::help() const
+{
+   cout << setw(15) << left << "CIRCEC: "
+        << "check the combinational equivalence of two circuits\n";
+}
+
 //----------------------------------------------------------------------
 //    CIRWrite [(int gateId)][-Output (string aagFile)]
 //----------------------------------------------------------------------
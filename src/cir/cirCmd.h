@@ -18,7 +18,9 @@ CmdClass(CirSweepCmd);
 CmdClass(CirOptCmd);
 CmdClass(CirStrashCmd);
 CmdClass(CirSimCmd);
+CmdClass(CirPatternCmd);
 CmdClass(CirFraigCmd);
+CmdClass(CirCecCmd);
 CmdClass(CirWriteCmd);
 
 #endif // CIR_CMD_H
@@ -16,8 +16,40 @@ using namespace std;
 
 // TODO: define your own typedef or enum
 
+// Random pattern generators of CIRSIMulate -Random
+enum SimPatGen {
+   SIM_UNIFORM,      // uniform random words
+   SIM_WEIGHT,       // per-PI probabilities read from a file
+   SIM_SIGPROB,      // PI biases derived from signal probabilities
+   SIM_FLIP          // distance-1 flips around the previous patterns
+};
+
+// Order in which CIRFraig proves the FEC candidate pairs
+enum FraigOrder {
+   FRAIG_LIST,       // group by group as the FEC groups are listed
+   FRAIG_SIZE,       // cheapest pairs first by fanin cone size
+   FRAIG_DEPTH       // cheapest pairs first by logic level
+};
+
+// Prover of CIRFraig for the pairs a small cut cannot decide
+enum FraigEngine {
+   FRAIG_SAT,        // SAT only
+   FRAIG_BDD,        // BDDs within a large node limit, then SAT
+   FRAIG_AUTO        // BDDs until the first blow-up, then SAT
+};
+
+// Initial SAT decision heuristics of CIRFraig, derived from the circuit
+enum FraigSeed {
+   FRAIG_SEED_NONE,    // activities start at 0
+   FRAIG_SEED_LEVEL,   // gates nearer the PIs are decided first
+   FRAIG_SEED_FANOUT,  // gates with more fanouts are decided first
+   FRAIG_SEED_SIM      // gates balanced in simulation first, in their majority value
+};
+
 class CirGate;
 class CirMgr;
 class SatSolver;
+class BddMgr;
+class SimThreadPool;
 
 #endif // CIR_DEF_H
@@ -7,9 +7,14 @@
 ****************************************************************************/
 
 #include <cassert>
+#include <queue>
+#include <algorithm>
+#include <unordered_map>
+#include <functional>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "sat.h"
+#include "bddMgr.h"
 #include "myHashMap.h"
 #include "util.h"
 
@@ -25,10 +30,55 @@ using namespace std;
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+extern unsigned globalRef;
+
+// SAT variable of "g" in its fec_inv phase, as the proof messages show it
+static string
+proofName(const CirGate* g)
+{
+  return (g->getFecInv() ? "!" : "") + to_string(g->getSatVar());
+}
+
+// Number of AIGs in the fanin cone of "g", counted up to "cap"
+static unsigned
+coneSize(CirGate* g, unsigned cap)
+{
+  ++globalRef;
+  vector<CirGate*> stack(1, g);
+  g->setRef(globalRef);
+  unsigned n = 0;
+  while (!stack.empty() && n < cap) {
+    CirGate* x = stack.back();
+    stack.pop_back();
+    if (!x->isAig()) continue;
+    ++n;
+    CirGate* in[2] = { x->fanin0_gate(), x->fanin1_gate() };
+    for (int i = 0; i < 2; ++i)
+      if (in[i]->ref() != globalRef) {
+        in[i]->setRef(globalRef);
+        stack.push_back(in[i]);
+      }
+  }
+  return n;
+}
 
 /*******************************************/
 /*   Public member functions about fraig   */
 /*******************************************/
+// Size of the SAT portfolio; more solvers than hardware threads would only
+// time-slice, so the size is capped there
+void
+CirMgr::setSatThreads(unsigned n)
+{
+  unsigned hw = SatSolver::maxPortfolio();
+  if (n > hw) {
+    cerr << "Warning: only " << hw << " hardware thread(s); using " << hw
+         << " SAT solver(s)!!" << endl;
+    n = hw;
+  }
+  _satThreads = n ? n : 1;
+}
+
 // _floatList may be changed.
 // _unusedList and _undefList won't be changed
 void
@@ -86,124 +136,30 @@ CirMgr::strash()
     buildFloatingList();
     buildDfsList();
   }
+  incrSim();
   strash_check = true;
 }
 
 void
-CirMgr::fraig()
+CirMgr::fraig(FraigOrder order, FraigEngine engine, FraigSeed seed)
 {
   strash_check = false;
   SatSolver solver;
   solver.initialize();
+  solver.setPortfolio(_satThreads);
+  solver.setSearchMode(restart_Luby, true);
+  solver.setPhaseSaving(true);
   genProofModel(solver);
-  size_t count = 0;
-  for (int i = 0, n = _fecGrpList.size(); i < n; ++i) {
-    vector<CirGate*>* fecGrp = _fecGrpList[i];
-    for (int j = 0, s =fecGrp->size(); j < s; ++j) {
-      for (int k = j+1; k < s; ++k) {
-        Var newV = solver.newVar(); bool result;
-        solver.addXorCNF(newV, fecGrp->at(j)->getSatVar(), fecGrp->at(j)->getFecInv(), fecGrp->at(k)->getSatVar(), fecGrp->at(k)->getFecInv());
-        solver.assumeRelease();
-        solver.assumeProperty(newV, true);
-        result = solver.assumpSolve();
-        if (!result) {  // equivalent
-          // merge
-          // fanout
-          string str1 = (fecGrp->at(j)->getFecInv()) ? "!" + to_string(fecGrp->at(j)->getSatVar()) : to_string(fecGrp->at(j)->getSatVar());
-          string str2 = (fecGrp->at(k)->getFecInv()) ? "!" + to_string(fecGrp->at(k)->getSatVar()) : to_string(fecGrp->at(k)->getSatVar());
-          cout << "Proving (" << str1 << ", " << str2 << ")...UNSAT!!\r";
-          vector<CirGateV> out = fecGrp->at(k)->output(); CirGate* g = fecGrp->at(k);
-          for (int u = 0, v = out.size(); u < v; ++u) {
-            if (out[u].gate()->fanin0_gate() == g) {
-              if (!out[u].isInv()){
-                if (fecGrp->at(j)->getFecInv() == g->getFecInv()){ 
-                  CirGateV temp(fecGrp->at(j), 0);
-                  out[u].gate()->setFanin0(temp);
-                }
-                else{
-                  CirGateV temp(fecGrp->at(j), 1);
-                  out[u].gate()->setFanin0(temp);
-                }
-              }
-              else {
-                if (fecGrp->at(j)->getFecInv() == g->getFecInv()) {
-                  CirGateV temp(fecGrp->at(j), 1);
-                  out[u].gate()->setFanin0(temp);
-                }
-                else{
-                  CirGateV temp(fecGrp->at(j), 0);
-                  out[j].gate()->setFanin0(temp);
-                }
-              }
-              
-            }
-            else {
-              if (!out[u].isInv()){
-                if (fecGrp->at(j)->getFecInv() == g->getFecInv()) {
-                  CirGateV temp(fecGrp->at(j), 0);
-                  out[u].gate()->setFanin0(temp);
-                }
-                else {
-                  CirGateV temp(fecGrp->at(j), 1);
-                  out[u].gate()->setFanin1(temp);
-                }
-              }
-              else {
-                if (fecGrp->at(j)->getFecInv() == g->getFecInv()) {
-                  CirGateV temp(fecGrp->at(j), 1);
-                  out[u].gate()->setFanin0(temp);
-                }
-                else {
-                  CirGateV temp(fecGrp->at(j), 0);
-                  out[j].gate()->setFanin1(temp);
-                }
-              }
-            }
-            if (fecGrp->at(j)->getFecInv() == g->getFecInv()){
-              fecGrp->at(j)->addFanout(out[u]);
-            }
-            else {
-              CirGateV a(out[u].gate(), !out[u].isInv());
-              fecGrp->at(j)->addFanout(a);
-            }
-          }
-          // fanin
-          for (vector<CirGateV>::iterator a = g->fanin0_gate()->output().begin(); a != g->fanin0_gate()->output().end();) {
-            if (a->gate() == g){
-              a = g->fanin0_gate()->output().erase(a);
-              break;
-            }
-            else
-              ++a;
-          }
-          for (vector<CirGateV>::iterator a = g->fanin1_gate()->output().begin(); a != g->fanin1_gate()->output().end();) {
-            if (a->gate() == g){
-              a = g->fanin1_gate()->output().erase(a);
-              break;
-            }
-            else
-              ++a;
-          }
-          if (fecGrp->at(j)->getFecInv() == g->getFecInv())
-            cout << "Fraig: " << fecGrp->at(j)->getVar() << " merging " << fecGrp->at(k)->getVar() << "..." << endl;
-          else
-            cout << "Fraig: " << fecGrp->at(j)->getVar() << " merging !" << fecGrp->at(k)->getVar() << "..." << endl;
-          _vAllGates[g->getVar()] = 0;
-          _nAIG -= 1;
-          fecGrp->erase(fecGrp->begin()+k);
-          --s; --k;
-          cout << "Updating by UNSAT... Total #FEC Group = " << _fecGrpList.size() << endl;
-        }
-        else {
-          cout << "Proving " << newV << " = " << "1...SAT!!\r";
-          ++count;
-          if (count == 64) {
-            count = 0;
-          }
-        }
-      }
-    }
-  }
+  pruneFecGrp();
+  seedProofModel(solver, seed);
+  initBddProver(engine);
+  if (order == FRAIG_LIST)
+    fraigInOrder(solver);
+  else
+    fraigByCost(solver, order);
+  delete _bddMgr;
+  _bddMgr = 0;
+  _bddOn = false;
   _fecGrpList.clear();
   for (size_t i = 0; i < _vDfsList.size(); ++i) {
     if (_vDfsList[i]->getFec())  _vDfsList[i]->setFec(0);
@@ -212,20 +168,30 @@ CirMgr::fraig()
   optimize();
   strash();
   buildDfsList();
+  incrSim();
 }
 
 /********************************************/
 /*   Private member functions about fraig   */
 /********************************************/
+// Each gate is first decided to its value in the first simulated pattern,
+// which is a consistent assignment of the whole circuit
 void
 CirMgr::genProofModel(SatSolver& s)
 {
   Var v = s.newVar();
   _vAllGates[0]->setSatVar(v);
+  s.assertProperty(v, false);
+  for (unsigned i = 0; i < _nPI; ++i) pi(i)->setSatVar(var_Undef);
+  // an undefined fanin is off the DFS list and simulates as constant 0
+  for (size_t i = 0, n = _vAllGates.size(); i < n; ++i)
+    if (_vAllGates[i] && _vAllGates[i]->isUndef()) _vAllGates[i]->setSatVar(v);
   for (size_t i = 0, n = _vDfsList.size(); i < n; ++i) {
+      if (_vDfsList[i]->isConst()) continue;     // keeps the var asserted above
       if (!_vDfsList[i]->isPo()) {
         v = s.newVar();
         _vDfsList[i]->setSatVar(v);
+        s.setPolarity(v, _vDfsList[i]->getPattern() & 1);
         if (_vDfsList[i]->isAig()) {
           CirGate* g = _vDfsList[i];
           s.addAigCNF( g->getSatVar(), g->fanin0_gate()->getSatVar(), g->fanin0_inv(), g->fanin1_gate()->getSatVar(), g->fanin1_inv());
@@ -236,4 +202,516 @@ CirMgr::genProofModel(SatSolver& s)
         _vDfsList[i]->setSatVar(v);
       }
    }
+  // a PI off the DFS list is unconstrained, but counterexamples still
+  // read its value
+  for (unsigned i = 0; i < _nPI; ++i)
+    if (pi(i)->getSatVar() == var_Undef) pi(i)->setSatVar(s.newVar());
+}
+
+// Give the gates of the proof model initial activities (scaled to [0, 1],
+// so the first conflicts already reorder them) and, for FRAIG_SEED_SIM,
+// the value they take in most of the simulated patterns
+void
+CirMgr::seedProofModel(SatSolver& s, FraigSeed seed) const
+{
+  if (seed == FRAIG_SEED_NONE) return;
+  size_t n = _vDfsList.size();
+  vector<unsigned> key(n, 0);
+  vector<unsigned> level(seed == FRAIG_SEED_LEVEL ? _vAllGates.size() : 0, 0);
+  unsigned maxKey = 0;
+  for (size_t i = 0; i < n; ++i) {
+    CirGate* g = _vDfsList[i];
+    if (g->isPo()) continue;
+    if (seed == FRAIG_SEED_LEVEL) {
+      if (g->isAig()) {
+        unsigned l0 = level[g->fanin0_gate()->getVar()], l1 = level[g->fanin1_gate()->getVar()];
+        level[g->getVar()] = ((l0 > l1) ? l0 : l1) + 1;
+      }
+      key[i] = level[g->getVar()];
+    }
+    else if (seed == FRAIG_SEED_FANOUT)
+      key[i] = g->nFanouts();
+    else {
+      unsigned ones = __builtin_popcountll(g->getPattern());
+      unsigned bits = sizeof(size_t) * 8;
+      s.setPolarity(g->getSatVar(), 2 * ones > bits);
+      key[i] = bits - ((2 * ones > bits) ? 2 * ones - bits : bits - 2 * ones);
+    }
+    if (key[i] > maxKey) maxKey = key[i];
+  }
+  if (maxKey == 0) return;
+  for (size_t i = 0; i < n; ++i) {
+    if (_vDfsList[i]->isPo()) continue;
+    unsigned k = (seed == FRAIG_SEED_LEVEL) ? maxKey - key[i] : key[i];
+    s.setActivity(_vDfsList[i]->getSatVar(), (double)k / maxKey);
+  }
+}
+
+// Prove "a" and "b" equivalent in their fec_inv phases, by a small cut
+// if possible and by SAT otherwise. A proven pair stays asserted in the
+// solver so that later proofs can use it.
+bool
+CirMgr::provePair(SatSolver& solver, CirGate* a, CirGate* b)
+{
+  string str1 = proofName(a), str2 = proofName(b);
+  int cut = quickCheck(a, b);
+  if (cut == 0) {
+    cout << "Proving (" << str1 << ", " << str2 << ")...differ!!\r";
+    return false;
+  }
+  Var newV = solver.newVar();
+  solver.addXorCNF(newV, a->getSatVar(), a->getFecInv(), b->getSatVar(), b->getFecInv());
+  if (cut < 0) {
+    solver.assumeRelease();
+    solver.assumeProperty(newV, true);
+    if (solver.assumpSolve()) {
+      cout << "Proving " << newV << " = " << "1...SAT!!\r";
+      return false;
+    }
+  }
+  cout << "Proving (" << str1 << ", " << str2 << ")...UNSAT!!\r";
+  solver.assertProperty(newV, false);
+  return true;
+}
+
+// Decide a pair by a small cut, or by BDDs if they are on; return 1
+// (equivalent), 0 (not equivalent) or -1 (unknown)
+int
+CirMgr::quickCheck(CirGate* a, CirGate* b)
+{
+  int cut = cutCheck(a, b);
+  if (cut < 0 && _bddOn)
+    cut = bddCheck(a, b);
+  return cut;
+}
+
+// Prove the pairs (a[i], b[i]), which quickCheck() cannot decide, with as
+// few SAT calls as possible: each call asks whether any of their miters
+// can be 1. UNSAT proves all the pairs still open; a model refutes every
+// pair it distinguishes (at least one), and the rest are asked again.
+// Each model is also shifted into "cexSig" (see harvestCex()). The proven
+// pairs stay asserted in the solver.
+void
+CirMgr::provePairs(SatSolver& solver, const vector<CirGate*>& a,
+                   const vector<CirGate*>& b, vector<bool>& proven,
+                   vector<size_t>& cexSig) const
+{
+  size_t n = a.size();
+  vector<Var> miter(n);
+  vector<size_t> open(n);
+  for (size_t i = 0; i < n; ++i) {
+    miter[i] = solver.newVar();
+    solver.addXorCNF(miter[i], a[i]->getSatVar(), a[i]->getFecInv(), b[i]->getSatVar(), b[i]->getFecInv());
+    open[i] = i;
+  }
+  proven.assign(n, false);
+  vector<Var> props;
+  while (!open.empty()) {
+    props.clear();
+    for (size_t k = 0; k < open.size(); ++k) props.push_back(miter[open[k]]);
+    solver.assumeRelease();
+    if (!solver.assumpSolveAny(props)) {
+      for (size_t k = 0; k < open.size(); ++k) {
+        proven[open[k]] = true;
+        solver.assertProperty(miter[open[k]], false);
+      }
+      cout << "Proving " << open.size() << " pairs...UNSAT!!\r";
+      break;
+    }
+    harvestCex(solver, cexSig);
+    size_t m = 0;
+    for (size_t k = 0; k < open.size(); ++k) {
+      if (solver.getValue(miter[open[k]]) == 1)
+        cout << "Proving " << miter[open[k]] << " = " << "1...SAT!!\r";
+      else
+        open[m++] = open[k];
+    }
+    open.resize(m);
+  }
+}
+
+// Shift the value of every gate (in its fec_inv phase) under the last
+// SAT model into its word of "cexSig". The words keep the last 64
+// counterexamples, and a pair whose words differ is refuted by one.
+void
+CirMgr::harvestCex(const SatSolver& solver, vector<size_t>& cexSig) const
+{
+  CirGate* c = _vAllGates[0];
+  cexSig[0] = (cexSig[0] << 1) | ((solver.getValue(c->getSatVar()) == 1) ^ c->getFecInv());
+  for (size_t i = 0, n = _vDfsList.size(); i < n; ++i) {
+    CirGate* g = _vDfsList[i];
+    if (!g->isAig()) continue;
+    size_t& w = cexSig[g->getVar()];
+    w = (w << 1) | ((solver.getValue(g->getSatVar()) == 1) ^ g->getFecInv());
+  }
+}
+
+// Decide "a" == "b" (in their fec_inv phases) without SAT: grow a common
+// cut of at most cutMaxLeaves gates from {a, b}, always expanding the
+// deepest leaf that still fits, and compare the truth tables of a and b
+// over the cut. Equal tables prove the pair. Different tables refute it
+// only if every leaf is a PI, since inner leaves may be correlated.
+// Return 1 (equivalent), 0 (not equivalent) or -1 (unknown).
+int
+CirMgr::cutCheck(CirGate* a, CirGate* b) const
+{
+  static const size_t cutMaxLeaves = 12;
+  static const size_t cutMaxExpand = 256;
+  static const size_t varMask[6] = {
+    0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+    0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL };
+
+  vector<CirGate*> leaves;
+  auto addLeaf = [&leaves] (CirGate* g) {
+    if (!g->isConst() && find(leaves.begin(), leaves.end(), g) == leaves.end())
+      leaves.push_back(g);
+  };
+  addLeaf(a);
+  addLeaf(b);
+  for (size_t nExpand = 0; nExpand < cutMaxExpand; ++nExpand) {
+    size_t best = leaves.size(), bestKey = 0;
+    for (size_t i = 0, n = leaves.size(); i < n; ++i) {
+      CirGate* g = leaves[i];
+      if (!g->isAig()) continue;
+      size_t grow = 0;
+      CirGate* in[2] = { g->fanin0_gate(), g->fanin1_gate() };
+      for (int j = 0; j < 2; ++j)
+        if (!in[j]->isConst() && find(leaves.begin(), leaves.end(), in[j]) == leaves.end()
+            && (j == 0 || in[1] != in[0]))
+          ++grow;
+      size_t key = inDfs(g) ? g->dfsId() + 1 : 0;
+      if (n - 1 + grow <= cutMaxLeaves && (best == n || key > bestKey)) {
+        best = i;
+        bestKey = key;
+      }
+    }
+    if (best == leaves.size()) break;
+    CirGate* g = leaves[best];
+    leaves.erase(leaves.begin() + best);
+    addLeaf(g->fanin0_gate());
+    addLeaf(g->fanin1_gate());
+  }
+
+  // truth tables of nW words over the leaves
+  size_t nLeaf = leaves.size();
+  size_t nW = (nLeaf <= 6) ? 1 : (size_t)1 << (nLeaf - 6);
+  vector<size_t> table;
+  unordered_map<const CirGate*, size_t> at;    // offset of a gate's table
+  for (size_t i = 0; i < nLeaf; ++i) {
+    at[leaves[i]] = table.size();
+    for (size_t w = 0; w < nW; ++w)
+      table.push_back(i < 6 ? varMask[i] : ((w >> (i - 6)) & 1) ? ~size_t(0) : 0);
+  }
+  function<size_t(const CirGate*)> eval = [&] (const CirGate* g) -> size_t {
+    auto it = at.find(g);
+    if (it != at.end()) return it->second;
+    size_t off;
+    if (g->isAig()) {
+      size_t o0 = eval(g->fanin0_gate()), o1 = eval(g->fanin1_gate());
+      size_t m0 = g->fanin0_inv() ? ~size_t(0) : 0, m1 = g->fanin1_inv() ? ~size_t(0) : 0;
+      off = table.size();
+      for (size_t w = 0; w < nW; ++w)
+        table.push_back((table[o0 + w] ^ m0) & (table[o1 + w] ^ m1));
+    }
+    else {                    // constant 0
+      off = table.size();
+      table.insert(table.end(), nW, 0);
+    }
+    at[g] = off;
+    return off;
+  };
+  size_t ta = eval(a), tb = eval(b);
+  size_t m = (a->getFecInv() != b->getFecInv()) ? ~size_t(0) : 0;
+  bool equal = true;
+  for (size_t w = 0; w < nW && equal; ++w)
+    equal = (table[ta + w] ^ m) == table[tb + w];
+  if (equal) return 1;
+  for (size_t i = 0; i < nLeaf; ++i)
+    if (!leaves[i]->isPi()) return -1;
+  return 0;
+}
+
+// Replace "g" by "rep" (complemented if their fec_inv differ) in all the
+// fanouts of "g" and drop "g" from the netlist
+void
+CirMgr::mergeGate(CirGate* rep, CirGate* g)
+{
+  // fanout
+  vector<CirGateV> out = g->output();
+  bool phase = (rep->getFecInv() != g->getFecInv());
+  for (int u = 0, v = out.size(); u < v; ++u) {
+    CirGateV temp(rep, out[u].isInv() != phase);
+    if (out[u].gate()->fanin0_gate() == g)
+      out[u].gate()->setFanin0(temp);
+    else
+      out[u].gate()->setFanin1(temp);
+    CirGateV a(out[u].gate(), out[u].isInv() != phase);
+    rep->addFanout(a);
+  }
+  // fanin
+  for (vector<CirGateV>::iterator a = g->fanin0_gate()->output().begin(); a != g->fanin0_gate()->output().end();) {
+    if (a->gate() == g){
+      a = g->fanin0_gate()->output().erase(a);
+      break;
+    }
+    else
+      ++a;
+  }
+  for (vector<CirGateV>::iterator a = g->fanin1_gate()->output().begin(); a != g->fanin1_gate()->output().end();) {
+    if (a->gate() == g){
+      a = g->fanin1_gate()->output().erase(a);
+      break;
+    }
+    else
+      ++a;
+  }
+  if (!phase)
+    cout << "Fraig: " << rep->getVar() << " merging " << g->getVar() << "..." << endl;
+  else
+    cout << "Fraig: " << rep->getVar() << " merging !" << g->getVar() << "..." << endl;
+  _vAllGates[g->getVar()] = 0;
+  _nAIG -= 1;
+}
+
+// Prove every pair of each FEC group, group by group
+// Only the constant and the gates in the proof model have a SAT variable:
+// drop the other FEC members (gates swept or strashed away since the
+// simulation) and the groups left with a single gate
+void
+CirMgr::pruneFecGrp()
+{
+  size_t c = 0;
+  for (size_t i = 0, n = _fecGrpList.size(); i < n; ++i) {
+    vector<CirGate*>* grp = _fecGrpList[i];
+    size_t s = 0;
+    for (size_t k = 0, m = grp->size(); k < m; ++k) {
+      CirGate* g = grp->at(k);
+      if (g == _vAllGates[0] || inDfs(g)) grp->at(s++) = g;
+      else g->setFec(0);
+    }
+    grp->resize(s);
+    if (s > 1) _fecGrpList[c++] = grp;
+    else {
+      if (s) grp->at(0)->setFec(0);
+      delete grp;
+    }
+  }
+  _fecGrpList.resize(c);
+}
+
+void
+CirMgr::fraigInOrder(SatSolver& solver)
+{
+  for (int i = 0, n = _fecGrpList.size(); i < n; ++i) {
+    vector<CirGate*>* fecGrp = _fecGrpList[i];
+    for (int j = 0, s =fecGrp->size(); j < s; ++j) {
+      for (int k = j+1; k < s; ++k) {
+        if (provePair(solver, fecGrp->at(j), fecGrp->at(k))) {
+          mergeGate(fecGrp->at(j), fecGrp->at(k));
+          fecGrp->erase(fecGrp->begin()+k);
+          --s; --k;
+          cout << "Updating by UNSAT... Total #FEC Group = " << _fecGrpList.size() << endl;
+        }
+      }
+    }
+  }
+}
+
+// Prove the cheap pairs first over all the groups. Members of a group are
+// sorted by (cost, DFS order) and walk their pairs (j, k), j < k, in that
+// order; a heap picks the group whose next pair is cheapest. Since the key
+// grows along every edge, the kept gate "j" is never in the fanout cone of
+// the merged gate "k", and merging keeps that true. The proven merges go
+// into the solver, which shrinks the later, more expensive proofs. Pairs
+// that need SAT are proven in batches, and the models found on the way
+// refute the later pairs they distinguish without another SAT call.
+void
+CirMgr::fraigByCost(SatSolver& solver, FraigOrder order)
+{
+  static const unsigned coneSizeCap = 1024;
+  vector<unsigned> cost(_vAllGates.size(), 0);
+  if (order == FRAIG_DEPTH) {
+    for (size_t i = 0, n = _vDfsList.size(); i < n; ++i) {
+      CirGate* g = _vDfsList[i];
+      if (!g->isAig()) continue;
+      unsigned l0 = cost[g->fanin0_gate()->getVar()], l1 = cost[g->fanin1_gate()->getVar()];
+      cost[g->getVar()] = ((l0 > l1) ? l0 : l1) + 1;
+    }
+  }
+  else {
+    for (size_t i = 0, n = _vDfsList.size(); i < n; ++i)
+      if (_vDfsList[i]->isAig() && _vDfsList[i]->getFec())
+        cost[_vDfsList[i]->getVar()] = coneSize(_vDfsList[i], coneSizeCap);
+  }
+
+  size_t c = _fecGrpList.size();
+  vector<vector<CirGate*> > grp(c);
+  for (size_t i = 0; i < c; ++i) {
+    grp[i] = *_fecGrpList[i];
+    sort(grp[i].begin(), grp[i].end(), [&cost] (CirGate* a, CirGate* b) {
+      unsigned ca = cost[a->getVar()], cb = cost[b->getVar()];
+      if (ca != cb) return ca < cb;
+      return (a->getVar() ? a->dfsId() + 1 : 0) < (b->getVar() ? b->dfsId() + 1 : 0);
+    });
+  }
+  // next pair of each group; members already merged are skipped
+  vector<size_t> pj(c, 0), pk(c, 1);
+  auto nextPair = [&] (size_t i) {
+    for (; pk[i] < grp[i].size(); ++pk[i], pj[i] = 0) {
+      for (; pj[i] < pk[i]; ++pj[i])
+        if (_vAllGates[grp[i][pj[i]]->getVar()]) return true;
+    }
+    return false;
+  };
+  auto pairCost = [&] (size_t i) {
+    return (size_t)cost[grp[i][pj[i]]->getVar()] + cost[grp[i][pk[i]]->getVar()];
+  };
+  typedef pair<size_t, size_t> Sched;   // (cost of the next pair, group)
+  priority_queue<Sched, vector<Sched>, greater<Sched> > heap;
+  for (size_t i = 0; i < c; ++i)
+    if (nextPair(i)) heap.push(Sched(pairCost(i), i));
+
+  // a pair quickCheck() cannot decide waits in the SAT batch; its group
+  // goes on once the batch is solved
+  static const size_t satBatchSize = 32;
+  size_t nMerged = 0;
+  auto settle = [&] (size_t i, bool equal) {
+    if (equal) {
+      mergeGate(grp[i][pj[i]], grp[i][pk[i]]);
+      ++pk[i], pj[i] = 0;
+      ++nMerged;
+    }
+    else
+      ++pj[i];
+    if (nextPair(i)) heap.push(Sched(pairCost(i), i));
+  };
+  vector<size_t> batch;
+  vector<CirGate*> ba, bb;
+  vector<bool> proven;
+  vector<size_t> cexSig(_vAllGates.size(), 0);
+  while (!heap.empty() || !batch.empty()) {
+    if (!heap.empty() && batch.size() < satBatchSize) {
+      size_t i = heap.top().second;
+      heap.pop();
+      CirGate *a = grp[i][pj[i]], *b = grp[i][pk[i]];
+      int cut = (cexSig[a->getVar()] != cexSig[b->getVar()]) ? 0 : quickCheck(a, b);
+      if (cut < 0) {
+        batch.push_back(i);
+        continue;
+      }
+      cout << "Proving (" << proofName(a) << ", " << proofName(b) << ")..."
+           << (cut ? "UNSAT" : "differ") << "!!\r";
+      if (cut == 1) {
+        Var v = solver.newVar();
+        solver.addXorCNF(v, a->getSatVar(), a->getFecInv(), b->getSatVar(), b->getFecInv());
+        solver.assertProperty(v, false);
+      }
+      settle(i, cut == 1);
+      continue;
+    }
+    ba.clear(); bb.clear();
+    for (size_t k = 0; k < batch.size(); ++k) {
+      ba.push_back(grp[batch[k]][pj[batch[k]]]);
+      bb.push_back(grp[batch[k]][pk[batch[k]]]);
+    }
+    provePairs(solver, ba, bb, proven, cexSig);
+    for (size_t k = 0; k < batch.size(); ++k)
+      settle(batch[k], proven[k]);
+    batch.clear();
+  }
+  cout << "Fraig: " << nMerged << " gates merged" << endl;
+}
+
+// BDD variables are the PIs (and undefined gates) in the order the DFS
+// list meets them, which keeps the inputs of a cone close together
+void
+CirMgr::initBddProver(FraigEngine engine)
+{
+  static const size_t bddMaxNodes = (size_t)1 << 20;
+  static const size_t bddAutoNodes = (size_t)1 << 16;
+  _bddOn = (engine != FRAIG_SAT);
+  _bddGiveUp = (engine == FRAIG_AUTO);
+  if (!_bddOn) return;
+  _bddVarOf.assign(_vAllGates.size(), ~0u);
+  unsigned nVar = 0;
+  for (size_t i = 0, n = _vDfsList.size(); i < n; ++i) {
+    CirGate* g = _vDfsList[i];
+    if (!g->isAig() && !g->isPo() && !g->isConst())
+      _bddVarOf[g->getVar()] = nVar++;
+  }
+  for (unsigned i = 0; i < _nPI; ++i)
+    if (_bddVarOf[_vPi[i]->getVar()] == ~0u)
+      _bddVarOf[_vPi[i]->getVar()] = nVar++;
+  _bddMgr = new BddMgr(nVar, (engine == FRAIG_BDD) ? bddMaxNodes : bddAutoNodes);
+  _bddOf.assign(_vAllGates.size(), BDD_FAIL);
+  _bddTooBig.assign(_vAllGates.size(), false);
+}
+
+// BDD of "g" from the BDDs of its fanin cone, built bottom-up without
+// recursion; BDD_FAIL if the node limit is hit or "g" has no BDD
+unsigned
+CirMgr::buildBdd(CirGate* g)
+{
+  vector<CirGate*> stack(1, g);
+  while (!stack.empty()) {
+    CirGate* x = stack.back();
+    unsigned v = x->getVar();
+    if (_bddOf[v] != BDD_FAIL) {
+      stack.pop_back();
+      continue;
+    }
+    Bdd f = BDD_FAIL;
+    if (x->isConst())
+      f = BDD_ZERO;
+    else if (!x->isAig()) {
+      if (_bddVarOf[v] == ~0u) return BDD_FAIL;
+      f = _bddMgr->ithVar(_bddVarOf[v]);
+    }
+    else {
+      CirGate *in0 = x->fanin0_gate(), *in1 = x->fanin1_gate();
+      if (_bddTooBig[in0->getVar()] || _bddTooBig[in1->getVar()]) {
+        _bddTooBig[v] = true;
+        return BDD_FAIL;
+      }
+      bool ready = true;
+      if (_bddOf[in0->getVar()] == BDD_FAIL) { stack.push_back(in0); ready = false; }
+      if (_bddOf[in1->getVar()] == BDD_FAIL) { stack.push_back(in1); ready = false; }
+      if (!ready) continue;
+      f = _bddMgr->bddAnd(_bddOf[in0->getVar()] ^ x->fanin0_inv(),
+                          _bddOf[in1->getVar()] ^ x->fanin1_inv());
+    }
+    if (f == BDD_FAIL) return BDD_FAIL;
+    _bddMgr->ref(f);
+    _bddOf[v] = f;
+    stack.pop_back();
+  }
+  return _bddOf[g->getVar()];
+}
+
+// Decide the pair by the BDDs of both gates over the inputs, which are
+// canonical. On a blow-up all the BDDs are dropped and built once more;
+// a gate that fails again is left to SAT from then on.
+// Return 1 (equivalent), 0 (not equivalent) or -1 (node limit hit).
+int
+CirMgr::bddCheck(CirGate* a, CirGate* b)
+{
+  if (_bddTooBig[a->getVar()] || _bddTooBig[b->getVar()]) return -1;
+  for (int tries = 0; tries < 2; ++tries) {
+    Bdd fa = buildBdd(a), fb = (fa == BDD_FAIL) ? fa : buildBdd(b);
+    if (fb != BDD_FAIL)
+      return (fa ^ a->getFecInv()) == (fb ^ b->getFecInv());
+    if (_bddTooBig[a->getVar()] || _bddTooBig[b->getVar()]) break;
+    if (tries) {
+      _bddTooBig[(fa == BDD_FAIL) ? a->getVar() : b->getVar()] = true;
+      break;
+    }
+    for (size_t i = 0, n = _bddOf.size(); i < n; ++i)
+      if (_bddOf[i] != BDD_FAIL) {
+        _bddMgr->deref(_bddOf[i]);
+        _bddOf[i] = BDD_FAIL;
+      }
+    _bddMgr->gc();
+  }
+  if (_bddGiveUp) _bddOn = false;
+  return -1;
 }
@@ -28,6 +28,15 @@ extern unsigned globalRef;
 /**************************************/
 /*   class CirGate member functions   */
 /**************************************/
+void
+CirGate::markSimDirty()
+{
+   if (!_simDirty && _mgr) {
+      _simDirty = true;
+      _mgr->simDirtyList().push_back(this);
+   }
+}
+
 void
 CirGate::reportGate() const
 {
@@ -48,7 +48,7 @@ private:
 class CirGate
 {
 public:
-   CirGate(unsigned l = 0, unsigned v = 0): _lineNo(l), _var(v), _ref(0) {}
+   CirGate(unsigned l = 0, unsigned v = 0): _lineNo(l), _var(v), _ref(0), _simPattern(0), sat_var(var_Undef) {}
    virtual ~CirGate() {}
 
    // Basic access methods
@@ -62,6 +62,8 @@ public:
    bool     getFecInv()    const { return fec_inv;                   }
    vector<CirGate*>* getFec() const { return _fec;                   }
    Var      getSatVar()    const {return sat_var;                    }
+   unsigned dfsId()        const { return _dfsId;                    }
+   bool     simDirty()     const { return _simDirty;                 }
 
          
    // Fanin       
@@ -97,16 +99,23 @@ public:
    void setLineNo(const unsigned l)     { _lineNo = l;                        }
    void setVar(const unsigned v)        { _var = v;                           }
    void setRef(const unsigned r)  const { _ref = r; /* const method orz... */ }
-   void setFanin0(const CirGateV& g)    { _fanin0 = g;                        } 
-   void setFanin1(const CirGateV& g)    { _fanin1 = g;                        } 
+   void setFanin0(const CirGateV& g)    { _fanin0 = g; markSimDirty();        } 
+   void setFanin1(const CirGateV& g)    { _fanin1 = g; markSimDirty();        } 
    void addFanout(const CirGateV& g)    { _fanouts.push_back(g);              } 
-   void setFanin0(CirGate* g, size_t i) { _fanin0 = CirGateV(g, i);           } 
-   void setFanin1(CirGate* g, size_t i) { _fanin1 = CirGateV(g, i);           } 
+   void setFanin0(CirGate* g, size_t i) { _fanin0 = CirGateV(g, i); markSimDirty(); } 
+   void setFanin1(CirGate* g, size_t i) { _fanin1 = CirGateV(g, i); markSimDirty(); } 
    void addFanout(CirGate* g, size_t i) { _fanouts.push_back(CirGateV(g, i)); }
    void setPattern(const size_t& a)     { _simPattern = a;                    } 
    void setFecInv(const bool a)         { fec_inv = a;                        }
    void setFec(vector<CirGate*>* a)     { _fec = a;                           }
    void setSatVar(const Var v)          { sat_var = v;                        }
+   void setDfsId(const unsigned i)      { _dfsId = i;                         }
+
+   // Incremental simulation: gates whose value may be stale are listed
+   // in the owning manager
+   void setMgr(CirMgr* m)               { _mgr = m;                           }
+   void markSimDirty();
+   void clearSimDirty()                 { _simDirty = false;                  }
 
    // Printing functions
    virtual void printGate() const = 0;
@@ -123,6 +132,9 @@ private:
    size_t            _simPattern;
    vector<CirGate*>* _fec;
    Var               sat_var;
+   unsigned          _dfsId = unsigned(-1);
+   bool              _simDirty = false;
+   CirMgr*           _mgr = 0;
 
 protected:
    CirGateV          _fanin0;
@@ -921,6 +921,7 @@ CirMgr::preProcess()
    _vAllGates.resize(1 + _maxIdx + _nPO, 0);
    // Create CONST gate
    CirConstGate* newGate = new CirConstGate;
+   newGate->setMgr(this);
    _vAllGates[0] = newGate;
 }
 
@@ -939,6 +940,7 @@ CirMgr::parsePi(ifstream& fin)
       if(!errorHandle(PI, tmp)) return false;
       lit = stoul(tmp);
       newPiGate = new CirPiGate(++lineNo, VAR(lit));
+      newPiGate->setMgr(this);
       _vAllGates[VAR(lit)] = newPiGate;
       _vPi.push_back(newPiGate);
    }
@@ -960,6 +962,7 @@ CirMgr::parsePo(ifstream& fin)
       if(!errorHandle(PO, tmp)) return false;
       lit = stoul(tmp);
       newPoGate = new CirPoGate(++lineNo, _maxIdx + 1 + i);
+      newPoGate->setMgr(this);
       fanin = queryGate(VAR(lit));
       newPoGate->setFanin0(fanin, INV(lit));
       fanin->addFanout(newPoGate, INV(lit));
@@ -1075,6 +1078,7 @@ CirMgr::queryGate(const unsigned gid) {
 
    // Create new aig gate
    CirAigGate* newGate = new CirAigGate(0, gid);
+   newGate->setMgr(this);
    _vAllGates[gid] = newGate;
    return newGate;
 }
@@ -1100,9 +1104,17 @@ CirMgr::buildDfsList()
 {
    _nDfsAIG = 0;
    ++globalRef;
-   _vDfsList.clear();
+   vector<CirGate*> old;
+   old.swap(_vDfsList);
    for(unsigned i = 0; i < _nPO; ++i)
       rec_dfs(po(i));
+   // gates that were not in the last list have never been kept up to date
+   for (unsigned i = 0, n = _vDfsList.size(); i < n; ++i) {
+      CirGate* g = _vDfsList[i];
+      if (g->dfsId() >= old.size() || old[g->dfsId()] != g)
+         g->markSimDirty();
+      g->setDfsId(i);
+   }
 }
 
 void
@@ -1162,6 +1174,8 @@ CirMgr::sortAllGateFanout()
 void
 CirMgr::clear()
 {
+   // Forget the dirty marks of the gates to be deleted
+   _simDirtyList.clear();
    // Delete gates
    for (unsigned i = 0, n = _vAllGates.size(); i < n; ++i)
       if (_vAllGates[i])
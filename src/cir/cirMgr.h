@@ -13,6 +13,7 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <functional>
 
 using namespace std;
 
@@ -20,6 +21,7 @@ using namespace std;
 
 #include "cirDef.h"
 #include "cirGate.h"
+#include "rnGen.h"
 
 extern CirMgr *cirMgr;
 enum CirParseType {
@@ -48,7 +50,7 @@ class CirMgr
 {
 public:
    CirMgr() {}
-   ~CirMgr() {} 
+   ~CirMgr() { releaseSimPool(); releaseSimKernel(); }
 
    // Access functions
    // return '0' if "gid" corresponds to an undefined gate.
@@ -73,14 +75,29 @@ public:
    void opt(CirGate* g);
 
    // Member functions about simulation
-   void randomSim();
+   vector<CirGate*>& simDirtyList() { return _simDirtyList; }
+   void randomSim(SimPatGen gen = SIM_UNIFORM);
+   bool readPiWeight(ifstream&);
    void fileSim(ifstream&);
-   void setSimLog(ofstream *logFile) { _simLog = logFile; }
+   bool binFileSim(const string&);
+   bool convertPattern(ifstream&, ofstream&);
+   static bool isBinPattern(ifstream&);
+   void setSimLog(ofstream *logFile, bool bin = false) { _simLog = logFile; _simLogBin = bin; }
+   void setSimSeed(size_t seed) { _simRnGen.setSeed(seed); }
+   void setSimThreads(unsigned n) { _simThreads = n ? n : 1; }
+   void setSimCompile(bool c) { _simCompile = c; }
+   void setSimAccum(bool a) { _simAccum = a; }
 
    // Member functions about fraig
+   void setSatThreads(unsigned n);
    void strash();
    void printFEC() const;
-   void fraig();
+   void fraig(FraigOrder order = FRAIG_LIST, FraigEngine engine = FRAIG_SAT,
+              FraigSeed seed = FRAIG_SEED_NONE);
+
+   // Member functions about equivalence checking
+   bool readMiter(const string&, const string&, bool byName = false);
+   bool cec(bool elim = false);
 
    // Member functions about circuit reporting
    void printSummary() const;
@@ -96,7 +113,45 @@ public:
    friend bool errorHandle(CirParseType, string);
 
 private:
-   ofstream           *_simLog;
+   ofstream           *_simLog = 0;
+   bool               _simLogBin = false;
+   vector<size_t>     _simLogWords;
+   vector<char>       _simLogBuf;
+   RandomNumGen64     _simRnGen;
+   vector<double>     _piWeight;
+   bool               _piPatValid = false;
+   vector<CirGate*>   _simDirtyList;   // gates marked by markSimDirty()
+   // flat simulation: blocks are queued and run _simRowWords per thread
+   unsigned           _simThreads = 1;
+   SimThreadPool      *_simPool = 0;    // workers of _simThreads > 1
+   unsigned           _satThreads = 1;     // SAT portfolio size
+   size_t             _simRowWords = 1;
+   vector<size_t>     _simBatchPat;    // _nPI words per queued block
+   vector<size_t>     _simBatchN;      // #patterns of each queued block
+   vector<unsigned>   _simNet;         // 2 fanin literals per slot
+   vector<unsigned>   _simPiSlot;      // slot of each PI (0: not in DFS)
+   vector<size_t>     _simVal;         // per thread: _simRowWords words per slot
+   size_t             _simLastBlk = 0;
+   // compiled simulation: the netlist as straight-line code in a .so
+   bool               _simCompile = false;
+   void*              _simLib = 0;
+   void             (*_simKernel)(size_t*) = 0;
+   vector<unsigned>   _simKernelNet;   // the _simNet the kernel was built for
+   size_t             _simKernelK = 0; // and its row width
+   // accumulated signatures: the FEC groups are split once per run
+   bool               _simAccum = false;
+   vector<size_t>     _simSig;         // 128 bits per slot
+   vector<unsigned char> _simSigPhase; // bit 0 of the first word of each slot
+   vector<unsigned>   _simSigSlots;    // slots of the FEC candidates
+   size_t             _simSigBlks = 0;
+   bool               _fecPhaseValid = false;  // fec_inv holds for all past patterns
+   // BDD prover of fraig; _bddOf holds a ref'ed BDD per gate (var)
+   BddMgr*            _bddMgr = 0;
+   bool               _bddOn = false;
+   bool               _bddGiveUp = false;       // stop after a blow-up
+   vector<unsigned>   _bddVarOf;
+   vector<unsigned>   _bddOf;
+   vector<bool>       _bddTooBig;      // no BDD within the node limit
    vector<string>     comment;
    bool               strash_check = false;
 
@@ -139,6 +194,37 @@ private:
    void preProcess();
    CirGate* queryGate(const unsigned);
 
+   // Private functions about simulation
+   void initFecGrp();
+   bool checkPattern(const string&) const;
+   void writeSimLog(size_t);
+   void simBlock(const size_t*, size_t);
+   void endSim();
+   void markSimValid();
+   void runSimThreads(size_t, const function<void(size_t)>&);
+   void releaseSimPool();
+   void runSimBatch();
+   void buildSimNet();
+   size_t simValue(size_t b, size_t slot) const {
+      size_t K = _simRowWords, t = b / K;
+      return _simVal[(t * (_simNet.size() / 2) + slot) * K + b % K];
+   }
+   void simNet(size_t);
+   bool compileSimNet();
+   void releaseSimKernel();
+   void refineFecGrp(size_t);
+   void accumSig(size_t);
+   void collectSigSlots();
+   void regroupBySig();
+   void genPattern(SimPatGen, size_t, vector<size_t>&);
+   size_t biasedWord(double);
+   void sigProbWeight();
+   void backtrace(CirGate*, bool, const vector<double>&, vector<int>&, vector<int>&);
+   size_t incrSim();
+   bool inDfs(const CirGate* g) const {
+      return g->dfsId() < _vDfsList.size() && _vDfsList[g->dfsId()] == g;
+   }
+
    // Private functions about gate lists
    void buildDfsList();
    void buildFloatingList();
@@ -154,6 +240,21 @@ private:
 
    //SAT
    void genProofModel(SatSolver& s);
+   void seedProofModel(SatSolver&, FraigSeed) const;
+   bool provePair(SatSolver&, CirGate*, CirGate*);
+   int quickCheck(CirGate*, CirGate*);
+   void provePairs(SatSolver&, const vector<CirGate*>&, const vector<CirGate*>&,
+                   vector<bool>&, vector<size_t>&) const;
+   void harvestCex(const SatSolver&, vector<size_t>&) const;
+   int cutCheck(CirGate*, CirGate*) const;
+   void initBddProver(FraigEngine);
+   unsigned buildBdd(CirGate*);
+   int bddCheck(CirGate*, CirGate*);
+   void mergeGate(CirGate*, CirGate*);
+   void pruneFecGrp();
+   void fraigInOrder(SatSolver&);
+   void fraigByCost(SatSolver&, FraigOrder);
+   bool buildMiter(CirMgr* c[2], bool byName);
 
 };
 
@@ -193,4 +294,19 @@ class SimKey
     size_t _key;
 };
 
+// Accumulated signature of a candidate within its current FEC group; the
+// group index carries the phase agreement with the past patterns in bit 0
+class SimSigKey
+{
+  public:
+    SimSigKey(size_t grp = 0, size_t s0 = 0, size_t s1 = 0) : _grp(grp), _s0(s0), _s1(s1) {}
+    size_t operator () () const { return _s0 ^ (_grp * 0x9e3779b97f4a7c15ULL); }
+    bool operator == (const SimSigKey& k) const {
+      return _grp == k._grp && _s0 == k._s0 && _s1 == k._s1; }
+  private:
+    size_t _grp;
+    size_t _s0;
+    size_t _s1;
+};
+
 #endif // CIR_MGR_H
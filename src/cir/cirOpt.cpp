@@ -101,6 +101,7 @@ CirMgr::optimize()
       buildUndefList();
       buildUnusedList();
   }
+  incrSim();
   strash_check = false;
 }
 
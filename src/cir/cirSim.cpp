@@ -15,6 +15,15 @@
 #include "cirGate.h"
 #include "util.h"
 #include <math.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dlfcn.h>
 
 using namespace std;
 
@@ -24,240 +33,1021 @@ using namespace std;
 /*******************************/
 /*   Global variable and enum  */
 /*******************************/
+extern unsigned globalRef;
 
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+// Value of "g" from the current values of its fanins
+static inline size_t
+evalPattern(const CirGate* g)
+{
+  if (g->isAig()) {
+    size_t in0 = (g->fanin0_inv()) ? ~g->fanin0_gate()->getPattern() : g->fanin0_gate()->getPattern();
+    size_t in1 = (g->fanin1_inv()) ? ~g->fanin1_gate()->getPattern() : g->fanin1_gate()->getPattern();
+    return in0 & in1;
+  }
+  if (g->isPo())
+    return (g->fanin0_inv()) ? ~g->fanin0_gate()->getPattern() : g->fanin0_gate()->getPattern();
+  return g->getPattern();
+}
+
+// Binary pattern file: a PatFileHeader followed by ceil(#pattern / 64)
+// blocks of #PI native-endian 64-bit words. Bit i of the j-th word in a
+// block is the value of PI j in pattern i of that block.
+static const char patMagic[8] = { 'F', 'R', 'A', 'I', 'G', 'P', 'A', 'T' };
+
+struct PatFileHeader
+{
+   char   magic[8];
+   size_t nPI;
+   size_t nPattern;
+};
+
+// Binary simulation log: a LogFileHeader followed by one record per block,
+// i.e. the number of patterns in the block, #PI PI words and #PO PO words.
+static const char logMagic[8] = { 'F', 'R', 'A', 'I', 'G', 'L', 'O', 'G' };
+
+struct LogFileHeader
+{
+   char   magic[8];
+   size_t nPI;
+   size_t nPO;
+};
+
+// In-place transpose of a 64x64 bit matrix:
+// afterwards bit s of a[k] is what bit k of a[s] was
+static void
+transpose64(size_t a[64])
+{
+  size_t m = 0x00000000FFFFFFFFUL;
+  for (unsigned j = 32; j != 0; j >>= 1, m ^= m << j) {
+    for (unsigned k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      size_t t = ((a[k] >> j) ^ a[k | j]) & m;
+      a[k] ^= t << j; a[k | j] ^= t;
+    }
+  }
+}
+
+// bitChars[v] holds '0'/'1' for the 8 bits of v, LSB first
+static char bitChars[256][8];
+
+static void
+initBitChars()
+{
+  if (bitChars[1][0] == '1') return;
+  for (unsigned v = 0; v < 256; ++v)
+    for (unsigned i = 0; i < 8; ++i)
+      bitChars[v][i] = ((v >> i) & 1) ? '1' : '0';
+}
+
+// Print the first "n" patterns of "nSig" signal words as '0'/'1' columns
+// starting at "buf"; consecutive patterns are "lineLen" chars apart
+static void
+formatBits(const size_t* words, size_t nSig, size_t n, char* buf, size_t lineLen)
+{
+  size_t blk[64];
+  for (size_t c = 0; c < nSig; c += 64) {
+    size_t m = (nSig - c < 64) ? nSig - c : 64;
+    for (size_t s = 0; s < 64; ++s)
+      blk[s] = (s < m) ? words[c + s] : 0;
+    transpose64(blk);
+    for (size_t k = 0; k < n; ++k) {
+      char* out = buf + k * lineLen + c;
+      size_t row = blk[k], s = 0;
+      for (; s + 8 <= m; s += 8, row >>= 8)
+        memcpy(out + s, bitChars[row & 0xff], 8);
+      for (; s < m; ++s, row >>= 1)
+        out[s] = (row & 1) ? '1' : '0';
+    }
+  }
+}
+
+// Workers 1 ~ n-1 of the simulation threads; they live as long as their
+// CirMgr and sleep between jobs. The caller is worker 0.
+class SimThreadPool
+{
+public:
+  SimThreadPool(size_t n) {
+    for (size_t t = 1; t < n; ++t)
+      _workers.push_back(thread(&SimThreadPool::work, this, t));
+  }
+  ~SimThreadPool() {
+    { lock_guard<mutex> l(_m); _quit = true; }
+    _start.notify_all();
+    for (size_t t = 0, n = _workers.size(); t < n; ++t)
+      _workers[t].join();
+  }
+  size_t size() const { return _workers.size() + 1; }
+
+  // Run job(0), ..., job(n-1) and wait for all of them (n <= size())
+  void run(size_t n, const function<void(size_t)>& job) {
+    assert(n <= size());
+    {
+      lock_guard<mutex> l(_m);
+      _job = &job; _n = n; _pending = n - 1; ++_round;
+    }
+    _start.notify_all();
+    job(0);
+    unique_lock<mutex> l(_m);
+    _done.wait(l, [this] { return _pending == 0; });
+  }
+
+private:
+  void work(size_t t) {
+    size_t seen = 0;
+    unique_lock<mutex> l(_m);
+    while (true) {
+      _start.wait(l, [&] { return _quit || _round != seen; });
+      if (_quit) return;
+      seen = _round;
+      if (t >= _n) continue;
+      const function<void(size_t)>* job = _job;
+      l.unlock();
+      (*job)(t);
+      l.lock();
+      if (--_pending == 0) _done.notify_one();
+    }
+  }
+
+  vector<thread>                    _workers;
+  mutex                             _m;
+  condition_variable                _start, _done;
+  const function<void(size_t)>*     _job = 0;
+  size_t                            _n = 0, _pending = 0, _round = 0;
+  bool                              _quit = false;
+};
 
 /************************************************/
 /*   Public member functions about Simulation   */
 /************************************************/
 void
-CirMgr::randomSim()
-{
-  // initialize
-  if ( _fecGrpList.size() == 0 ) {
-    vector<CirGate*>* fecGrp = new vector<CirGate*>;
-    fecGrp->push_back(_vAllGates[0]);
-    for (int i = 0, s = _vAllGates.size() ; i < s ; ++i) {
-      if (_vAllGates[i]->isAig()) 
-        fecGrp->push_back(_vAllGates[i]);
-    }
-    _fecGrpList.push_back(fecGrp);
-  }
+CirMgr::randomSim(SimPatGen gen)
+{
+  initFecGrp();
+  if (_piWeight.size() != _nPI)
+    _piWeight.assign(_nPI, 0.5);
   // random value
+  vector<size_t> piPat(_nPI);
   int max = (_vDfsList.size() < 100) ? _vDfsList.size() : sqrt(_vDfsList.size()) * 5;
   for (int i = 0; i < max; ++i) {
-    for (int j = 0, n = _vPi.size(); j < n; ++j) {
-      size_t temp = (size_t)(rnGen(INT_MAX) << 32) | (size_t)rnGen(INT_MAX);
-      _vPi[j]->setPattern(temp);
+    // the FEC groups change as we go; re-derive the biases once in a while
+    if (gen == SIM_SIGPROB && i % 16 == 0) {
+      if (_simAccum) regroupBySig();
+      sigProbWeight();
     }
-    for (int j = 0, n = _vDfsList.size(); j < n; ++j) {
-      if (_vDfsList[j]->isAig()) {
-        size_t in0 = (_vDfsList[j]->fanin0_inv()) ? ~_vDfsList[j]->fanin0_gate()->getPattern() : _vDfsList[j]->fanin0_gate()->getPattern();
-        size_t in1 = (_vDfsList[j]->fanin1_inv()) ? ~_vDfsList[j]->fanin1_gate()->getPattern() : _vDfsList[j]->fanin1_gate()->getPattern();
-        size_t value = in0 & in1;
-        _vDfsList[j]->setPattern(value);
-      }
-      else if (_vDfsList[j]->isPo()) {
-        size_t value = (_vDfsList[j]->fanin0_inv()) ? ~_vDfsList[j]->fanin0_gate()->getPattern() : _vDfsList[j]->fanin0_gate()->getPattern();
-        _vDfsList[j]->setPattern(value);
-      }
+    genPattern(gen, i, piPat);
+    simBlock(piPat.data(), 64);
+  }
+  endSim();
+  cout << max*64 << " patterns simulated." << endl;
+  
+}
+
+// Patterns are streamed in blocks of 64: each block is packed into one word
+// per PI, simulated, used to refine the FEC groups and then discarded, so
+// the memory usage does not depend on the size of the pattern file. The
+// file is read twice, as nothing is simulated or logged unless every
+// pattern is valid.
+void
+CirMgr::fileSim(ifstream& patternFile)
+{
+  // a bad pattern anywhere discards the whole file: check it all first
+  string temp;
+  while (patternFile >> temp) {
+    if (!checkPattern(temp)) {
+      cout << "0 patterns simulated." << endl;
+      return;
     }
-    // FEC
-    size_t c = _fecGrpList.size();
-    for (int j = 0, n = _fecGrpList.size(); j < n; ++j) {
-      if (!_fecGrpList[j]->empty()) {
-        HashMap< SimKey, vector<CirGate*>* > newfeclist(_fecGrpList[j]->size());
-        for (int k = 0, l = _fecGrpList[j]->size(); k < l; ++k) {
-          SimKey newkey(_fecGrpList[j]->at(k)->getPattern()); SimKey i_newkey(~_fecGrpList[j]->at(k)->getPattern());
-          vector<CirGate*>* temp = 0;
-          if (newfeclist.query(newkey, temp)) {
-            _fecGrpList[j]->at(k)->setFecInv(false);
-            _fecGrpList[j]->at(k)->setFec(temp);
-            temp->push_back(_fecGrpList[j]->at(k));
-          }
-          else if (newfeclist.query(i_newkey, temp)) {
-            _fecGrpList[j]->at(k)->setFecInv(true);
-            _fecGrpList[j]->at(k)->setFec(temp);
-            temp->push_back(_fecGrpList[j]->at(k));
-          }
-          else {
-            temp = new vector<CirGate*>;
-            _fecGrpList[j]->at(k)->setFecInv(false);
-            _fecGrpList[j]->at(k)->setFec(temp);
-            temp->push_back(_fecGrpList[j]->at(k));
-            _fecGrpList.push_back(temp);
-            newfeclist.insert(newkey, temp);
-          }
-        }
-      }
+  }
+  patternFile.clear();
+  patternFile.seekg(0);
+
+  initFecGrp();
+  vector<size_t> piPat(_nPI, 0);
+  size_t p = 0;
+  while (true) {
+    size_t n = 0;
+    fill(piPat.begin(), piPat.end(), 0);
+    while (n < 64 && patternFile >> temp) {
+      for (size_t i = 0; i < _nPI; ++i)
+        if (temp[i] == '1') piPat[i] |= (size_t)1 << n;
+      ++n;
     }
-    vector<vector<CirGate*>*> x;
-    for ( size_t k = c, l = _fecGrpList.size() ; k < l ; ++k ) {
-      if ( _fecGrpList[k]->size() > 1 )  
-        x.push_back(_fecGrpList[k]);
+    if (n == 0) break;
+
+    simBlock(piPat.data(), n);
+    p += n;
+    if (n < 64) break;
+  }
+  endSim();
+  cout << p << " patterns simulated." << endl;
+}
+
+// Read one probability (0 ~ 1) of being 1 per PI for -Weight
+bool
+CirMgr::readPiWeight(ifstream& weightFile)
+{
+  vector<double> w;
+  string temp;
+  while (weightFile >> temp) {
+    char* end = 0;
+    double p = strtod(temp.c_str(), &end);
+    if (*end != 0 || p < 0 || p > 1) {
+      cerr << "Error: Illegal PI weight \"" << temp << "\"!!" << endl;
+      return false;
     }
-    _fecGrpList.clear();
-    _fecGrpList = x;
+    w.push_back(p);
+  }
+  if (w.size() != _nPI) {
+    cerr << "Error: Number of PI weights(" << w.size() << ") does not match the number of inputs(" << _nPI << ") in a circuit!!" << endl;
+    return false;
+  }
+  _piWeight.swap(w);
+  return true;
+}
+
+// Replay a binary pattern file; the file is mapped into memory and the
+// words are fed to the PIs directly without any parsing
+bool
+CirMgr::binFileSim(const string& fileName)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    cerr << "Error: cannot open pattern file \"" << fileName << "\"!!" << endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PatFileHeader)) {
+    cerr << "Error: \"" << fileName << "\" is not a binary pattern file!!" << endl;
+    close(fd);
+    return false;
+  }
+  void* base = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    cerr << "Error: cannot map pattern file \"" << fileName << "\"!!" << endl;
+    return false;
+  }
+  madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+  const PatFileHeader* h = (const PatFileHeader*)base;
+  size_t nBlk = h->nPattern / 64 + (h->nPattern % 64 != 0);
+  if (h->nPI != _nPI) {
+    cerr << "Error: Pattern file has " << h->nPI << " inputs, which does not match the number of inputs(" << _nPI << ") in a circuit!!" << endl;
+    munmap(base, st.st_size);
+    return false;
+  }
+  // The header counts are not to be trusted: the payload must be exactly
+  // nBlk blocks of #PI words (compared by division, so nothing can wrap).
+  // Without PIs there are no words, and no pattern can be stored either.
+  size_t payload = st.st_size - sizeof(PatFileHeader);
+  size_t blkBytes = _nPI * sizeof(size_t);
+  bool fits = _nPI ? (nBlk <= payload / blkBytes && payload == nBlk * blkBytes)
+                   : (h->nPattern == 0 && payload == 0);
+  if (!fits) {
+    cerr << "Error: binary pattern file \"" << fileName << "\" does not match its header!!" << endl;
+    munmap(base, st.st_size);
+    return false;
+  }
+
+  initFecGrp();
+  const size_t* w = (const size_t*)(h + 1);
+  for (size_t b = 0; b < nBlk; ++b, w += _nPI) {
+    size_t n = (b + 1 < nBlk) ? 64 : h->nPattern - b * 64;
+    simBlock(w, n);
+  }
+  endSim();
+  cout << h->nPattern << " patterns simulated." << endl;
+  munmap(base, st.st_size);
+  return true;
+}
 
-    size_t w = 0;
-    for (int j = 0, n = _fecGrpList.size(); j < n; ++j) {
-      if (_fecGrpList[j]->size() > 1)
-        w += 1;
+// Convert an ASCII pattern file into the binary format read by binFileSim()
+bool
+CirMgr::convertPattern(ifstream& patternFile, ofstream& binFile)
+{
+  PatFileHeader h;
+  memcpy(h.magic, patMagic, sizeof(patMagic));
+  h.nPI = _nPI; h.nPattern = 0;
+  binFile.write((const char*)&h, sizeof(h));
+
+  vector<size_t> piPat(_nPI, 0);
+  string temp;
+  bool valid = true;
+  while (valid) {
+    size_t n = 0;
+    fill(piPat.begin(), piPat.end(), 0);
+    while (n < 64 && patternFile >> temp) {
+      if (!checkPattern(temp)) { valid = false; break; }
+      for (size_t i = 0; i < _nPI; ++i)
+        if (temp[i] == '1') piPat[i] |= (size_t)1 << n;
+      ++n;
     }
-    cout << "Total #FEC Group = " << w << "\r" ;
+    if (n == 0) break;
+    binFile.write((const char*)piPat.data(), _nPI * sizeof(size_t));
+    h.nPattern += n;
+    if (n < 64) break;
   }
-  cout << max*64 << " patterns simulated." << endl;
-  
+
+  binFile.seekp(0);
+  binFile.write((const char*)&h, sizeof(h));
+  if (valid)
+    cout << h.nPattern << " patterns converted." << endl;
+  return valid;
+}
+
+bool
+CirMgr::isBinPattern(ifstream& patternFile)
+{
+  char magic[sizeof(patMagic)];
+  patternFile.read(magic, sizeof(magic));
+  bool isBin = patternFile.gcount() == sizeof(magic) && memcmp(magic, patMagic, sizeof(magic)) == 0;
+  patternFile.clear();
+  patternFile.seekg(0);
+  return isBin;
 }
 
+/*************************************************/
+/*   Private member functions about Simulation   */
+/*************************************************/
+// Put CONST and all AIGs into one group before the first simulation
 void
-CirMgr::fileSim(ifstream& patternFile)
+CirMgr::initFecGrp()
+{
+  if (!_fecGrpList.empty()) return;
+  vector<CirGate*>* fecGrp = new vector<CirGate*>;
+  fecGrp->push_back(_vAllGates[0]);
+  _fecPhaseValid = false;
+  for (int i = 0, s = _vAllGates.size() ; i < s ; ++i) {
+    if (_vAllGates[i] && _vAllGates[i]->isAig()) 
+      fecGrp->push_back(_vAllGates[i]);
+  }
+  _fecGrpList.push_back(fecGrp);
+}
+
+// Everything in the DFS list is up to date with the PI patterns now
+void
+CirMgr::markSimValid()
+{
+  _piPatValid = true;
+  vector<CirGate*>& dirty = _simDirtyList;
+  for (size_t i = 0, n = dirty.size(); i < n; ++i)
+    dirty[i]->clearSimDirty();
+  dirty.clear();
+}
+
+// Run job(0), ..., job(n-1) on the simulation threads; a single job runs
+// in the caller. The pool follows the last setSimThreads().
+void
+CirMgr::runSimThreads(size_t n, const function<void(size_t)>& job)
+{
+  if (n <= 1) {
+    if (n) job(0);
+    return;
+  }
+  if (!_simPool || _simPool->size() != _simThreads) {
+    releaseSimPool();
+    _simPool = new SimThreadPool(_simThreads);
+  }
+  _simPool->run(n, job);
+}
+
+void
+CirMgr::releaseSimPool()
+{
+  delete _simPool;
+  _simPool = 0;
+}
+
+// Simulate one block of "n" (<= 64) patterns given as one word per PI.
+// Blocks are queued and run in batches; see runSimBatch().
+void
+CirMgr::simBlock(const size_t* piPat, size_t n)
+{
+  for (size_t j = 0; j < _nPI; ++j)
+    _vPi[j]->setPattern(piPat[j]);
+  if (_simNet.empty())
+    buildSimNet();
+  _simBatchPat.insert(_simBatchPat.end(), piPat, piPat + _nPI);
+  _simBatchN.push_back(n);
+  if (_simBatchN.size() == _simThreads * _simRowWords)
+    runSimBatch();
+}
+
+// Run what is still queued, leave the gates with the values of the last
+// block and put the FEC groups in a deterministic order
+void
+CirMgr::endSim()
+{
+  if (!_simBatchN.empty())
+    runSimBatch();
+  if (_simAccum) {
+    regroupBySig();
+    vector<size_t>().swap(_simSig);
+    vector<unsigned char>().swap(_simSigPhase);
+    vector<unsigned>().swap(_simSigSlots);
+  }
+  if (!_simNet.empty()) {
+    for (size_t i = 0, n = _vDfsList.size(); i < n; ++i)
+      _vDfsList[i]->setPattern(simValue(_simLastBlk, i + 1));
+    markSimValid();
+    vector<unsigned>().swap(_simNet);
+    vector<size_t>().swap(_simVal);
+  }
+  sort(_fecGrpList.begin(), _fecGrpList.end(), 
+        [] (const vector<CirGate*>* g1, const vector<CirGate*>* g2) {
+           return g1->at(0)->getVar() < g2->at(0)->getVar();
+        });
+}
+
+// Flatten the DFS list for simulation: DFS gate i becomes slot i+1 and
+// slot 0 holds constant 0 for every gate outside the list. The values live
+// in plain arrays in DFS order instead of in the scattered gate objects, so
+// each cone sits together and a fanin is usually a few slots back.
+// A literal is (slot << 1 | inverted); PIs are marked with simPiLit.
+// Each slot owns a row of _simRowWords words, one per block, so a node is
+// evaluated for all the blocks of a thread while its fanin rows are in
+// cache; rows are narrowed for huge netlists to bound the memory.
+static const unsigned simPiLit = ~0u;
+static const size_t   simMaxRowWords = 16;
+static const size_t   simValBudget = (size_t)1 << 28;    // bytes
+
+void
+CirMgr::buildSimNet()
 {
-  if ( _fecGrpList.empty() ) {
-    vector<CirGate*>* fecGrp = new vector<CirGate*>;
-    fecGrp->push_back(_vAllGates[0]);
-    for (int i = 0, s = _vAllGates.size() ; i < s ; ++i) {
-      if (_vAllGates[i]->isAig()) 
-        fecGrp->push_back(_vAllGates[i]);
+  size_t nSlot = _vDfsList.size() + 1;
+  _simNet.assign(2 * nSlot, 0);
+  auto lit = [this] (const CirGate* g, bool inv) {
+    return (inDfs(g) ? (g->dfsId() + 1) << 1 : 0) | inv;
+  };
+  for (size_t i = 0; i < _vDfsList.size(); ++i) {
+    CirGate* g = _vDfsList[i];
+    unsigned* l = &_simNet[2 * (i + 1)];
+    if (g->isAig()) {
+      l[0] = lit(g->fanin0_gate(), g->fanin0_inv());
+      l[1] = lit(g->fanin1_gate(), g->fanin1_inv());
     }
-    _fecGrpList.push_back(fecGrp);
+    else if (g->isPo()) {
+      l[0] = lit(g->fanin0_gate(), g->fanin0_inv());
+      l[1] = 1;                                    // constant 1
+    }
+    else if (g->isPi())
+      l[0] = l[1] = simPiLit;
   }
-  size_t p = 0;
-  string temp; vector<string> input;
-  while (patternFile >> temp) {
-    if (temp.size() != _nPI)
-      cerr << "Error: Pattern(" << temp << ") length(" << temp.size() << ") does not match the number of inputs(" << _nPI << ") in a circuit!!" << endl;
-    input.resize(_nPI);
-    for (int i = 0, s = temp.size(); i < s; ++i) {
-      if (temp[i] != '0' && temp[i] != '1')
-        cerr << "Error: Pattern(" << temp << ") contains a non-0/1 character(‘" << temp[i] << "’)." << endl;
-      string t = temp.substr(i,1);
-      input[i] += t;
+  _simPiSlot.assign(_nPI, 0);
+  for (size_t j = 0; j < _nPI; ++j)
+    if (inDfs(_vPi[j])) _simPiSlot[j] = _vPi[j]->dfsId() + 1;
+
+  size_t w = simValBudget / (nSlot * sizeof(size_t) * _simThreads);
+  _simRowWords = (w < 1) ? 1 : (w > simMaxRowWords) ? simMaxRowWords : w;
+  _simVal.assign(_simThreads * _simRowWords * nSlot, 0);
+  if (_simAccum) {
+    _simSig.assign(2 * nSlot, 0);
+    _simSigPhase.assign(nSlot, 0);
+    _simSigBlks = 0;
+    collectSigSlots();
+  }
+  if (_simCompile && !compileSimNet())
+    cerr << "Warning: cannot build the compiled simulator; interpreting the netlist!!" << endl;
+}
+
+// Emit _simNet as straight-line C with the row width fixed, compile it with
+// the host compiler ($CC, default "cc") into a shared object and load it
+// as the evaluation kernel of simNet(). The code is cut into functions of
+// a few hundred nodes to keep the compile time of large netlists bearable.
+// The kernel stays loaded and is reused while _simNet and the row width
+// are the same, so only the first run on a netlist pays for the compile.
+bool
+CirMgr::compileSimNet()
+{
+  static const size_t nodesPerFunc = 512;
+  if (_simKernel && _simKernelK == _simRowWords && _simKernelNet == _simNet)
+    return true;
+  releaseSimKernel();
+  char dir[] = "/tmp/fraigsimXXXXXX";
+  if (!mkdtemp(dir)) return false;
+  string src = string(dir) + "/sim.c", lib = string(dir) + "/sim.so";
+  string log = string(dir) + "/cc.log";
+  ofstream out(src.c_str());
+  out << "#include <stdint.h>\n"
+      << "#define K " << _simRowWords << "\n"
+      << "#define M (~(uint64_t)0)\n"
+      << "#define AND(o, a, ma, b, mb) "
+      << "v[(o) * K + k] = (v[(a) * K + k] ^ (ma)) & (v[(b) * K + k] ^ (mb));\n";
+  size_t nSlot = _simNet.size() / 2, nFunc = 0;
+  for (size_t i = 1; i < nSlot; ++nFunc) {
+    out << "static void f" << nFunc << "(uint64_t* v) {\n"
+        << "for (int k = 0; k < K; ++k) {\n";
+    for (size_t n = 0; i < nSlot && n < nodesPerFunc; ++i) {
+      unsigned l0 = _simNet[2 * i], l1 = _simNet[2 * i + 1];
+      if (l0 == simPiLit) continue;
+      out << "AND(" << i << "UL," << (l0 >> 1) << "UL," << ((l0 & 1) ? "M" : "0")
+          << "," << (l1 >> 1) << "UL," << ((l1 & 1) ? "M" : "0") << ")\n";
+      ++n;
     }
+    out << "}\n}\n";
   }
+  out << "void fraigSimKernel(uint64_t* v) {\n";
+  for (size_t f = 0; f < nFunc; ++f)
+    out << "f" << f << "(v);\n";
+  out << "}\n";
+  out.close();
 
-  for (int u = 0, v = input[0].size(); u < v; u += 64)
-  {
-    vector<string> in; in.resize(_nPI);
-    for (int i = 0, s = _nPI; i < s; ++i)
-    {
-      in[i] = (input[i].size() - u < 64) ? input[i].substr(u, input[i].size() - u) : input[i].substr(u, 64);
-      size_t x = 0;
-      for (int j = 0, n = in[i].size(); j < n; ++j)
-      {
-        x += (size_t) stoi(in[i].substr(j,1)) * (size_t) pow(2, j);
+  const char* cc = getenv("CC");
+  string cmd = string(cc ? cc : "cc") + " -O1 -shared -fPIC -o " + lib + " " + src
+             + " > " + log + " 2>&1";
+  bool ok = out && system(cmd.c_str()) == 0;
+  if (ok) {
+    _simLib = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (_simLib)
+      *(void**)&_simKernel = dlsym(_simLib, "fraigSimKernel");
+    ok = _simKernel != 0;
+  }
+  if (ok) {
+    _simKernelNet = _simNet;
+    _simKernelK = _simRowWords;
+  }
+  unlink(src.c_str());
+  unlink(lib.c_str());
+  unlink(log.c_str());
+  rmdir(dir);
+  if (!ok) releaseSimKernel();
+  return ok;
+}
+
+void
+CirMgr::releaseSimKernel()
+{
+  if (_simLib) dlclose(_simLib);
+  _simLib = 0;
+  _simKernel = 0;
+  vector<unsigned>().swap(_simKernelNet);
+}
+
+// Evaluate the queued blocks of thread "t" (blocks t*K .. t*K+K-1 where K
+// is _simRowWords) into its own value rows
+void
+CirMgr::simNet(size_t t)
+{
+  size_t K = _simRowWords, nSlot = _simNet.size() / 2;
+  size_t b0 = t * K, nBlk = _simBatchN.size();
+  if (b0 >= nBlk) return;
+  size_t k1 = (nBlk - b0 < K) ? nBlk - b0 : K;
+  size_t* val = &_simVal[t * K * nSlot];
+  const unsigned* l = &_simNet[0];
+  for (size_t j = 0; j < _nPI; ++j) {
+    const size_t* pat = &_simBatchPat[b0 * _nPI + j];
+    size_t* row = val + _simPiSlot[j] * K;
+    for (size_t k = 0; k < k1; ++k)
+      row[k] = pat[k * _nPI];
+  }
+  for (size_t k = 0; k < K; ++k)
+    val[k] = 0;               // PIs outside the DFS list landed here
+  if (_simCompile && _simKernel) {
+    _simKernel(val);
+    return;
+  }
+  for (size_t i = 1; i < nSlot; ++i) {
+    unsigned l0 = l[2 * i], l1 = l[2 * i + 1];
+    if (l0 == simPiLit) continue;
+    const size_t* in0 = val + (l0 >> 1) * K;
+    const size_t* in1 = val + (l1 >> 1) * K;
+    size_t m0 = 0 - (size_t)(l0 & 1), m1 = 0 - (size_t)(l1 & 1);
+    size_t* out = val + i * K;
+    for (size_t k = 0; k < k1; ++k)
+      out[k] = (in0[k] ^ m0) & (in1[k] ^ m1);
+  }
+}
+
+// Simulate the queued blocks, K per thread, write their logs in order and
+// refine the FEC groups with all of them at once
+void
+CirMgr::runSimBatch()
+{
+  size_t nBlk = _simBatchN.size();
+  size_t nThread = (nBlk + _simRowWords - 1) / _simRowWords;
+  runSimThreads(nThread, [this] (size_t t) { simNet(t); });
+
+  if (_simLog) {
+    for (size_t b = 0; b < nBlk; ++b) {
+      for (size_t j = 0; j < _nPI; ++j)
+        _vPi[j]->setPattern(_simBatchPat[b * _nPI + j]);
+      for (unsigned j = 0; j < _nPO; ++j)
+        po(j)->setPattern(simValue(b, po(j)->dfsId() + 1));
+      writeSimLog(_simBatchN[b]);
+    }
+  }
+  if (_simAccum)
+    accumSig(nBlk);
+  else {
+    refineFecGrp(nBlk);
+    cout << "Total #FEC Group = " << _fecGrpList.size() << "\r";
+  }
+  _simLastBlk = nBlk - 1;
+  _simBatchPat.clear();
+  _simBatchN.clear();
+}
+
+// Split the FEC groups by "nBlk" blocks at once. A gate's words are taken
+// in the phase of its first pattern, so a gate and its complement hash to
+// the same signature and one probe finds both; the phase goes to fec_inv
+// and must agree with the fec_inv the gate had before. The result is the
+// same as refining block by block. Signatures are computed and groups are
+// split in parallel, each group by one thread.
+void
+CirMgr::refineFecGrp(size_t nBlk)
+{
+  size_t c = _fecGrpList.size();
+  vector<size_t> first(c + 1, 0);
+  for (size_t i = 0; i < c; ++i)
+    first[i + 1] = first[i] + _fecGrpList[i]->size();
+  vector<size_t> sig(first[c]);
+  vector<unsigned char> phase(first[c]);
+
+  auto signature = [&] (size_t t) {
+    for (size_t i = t; i < c; i += _simThreads) {
+      vector<CirGate*>* grp = _fecGrpList[i];
+      for (size_t k = 0, n = grp->size(); k < n; ++k) {
+        CirGate* g = grp->at(k);
+        size_t slot = inDfs(g) ? g->dfsId() + 1 : 0;
+        bool p = simValue(0, slot) & 1;
+        size_t h = 0, m = p ? ~size_t(0) : 0;
+        for (size_t b = 0; b < nBlk; ++b) {
+          h += simValue(b, slot) ^ m;
+          h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+          h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+          h ^= h >> 31;
+        }
+        // bit 0: does the phase keep the relation to the group so far?
+        bool q = _fecPhaseValid && (p != g->getFecInv());
+        sig[first[i] + k] = (h << 1) | q;
+        phase[first[i] + k] = p;
       }
-      _vPi[i]->setPattern(x);
     }
+  };
+  vector<vector<vector<CirGate*>*> > newGrp(c);
+  auto split = [&] (size_t t) {
+    for (size_t i = t; i < c; i += _simThreads) {
+      vector<CirGate*>* grp = _fecGrpList[i];
+      HashMap<SimKey, size_t> newfeclist(grp->size());
+      vector<unsigned char> leadPhase;
+      for (size_t k = 0, n = grp->size(); k < n; ++k) {
+        CirGate* g = grp->at(k);
+        SimKey key(sig[first[i] + k]);
+        size_t id = size_t(-1);       // query() only reports data != id
+        if (!newfeclist.query(key, id)) {
+          id = newGrp[i].size();
+          newfeclist.insert(key, id);
+          newGrp[i].push_back(new vector<CirGate*>);
+          leadPhase.push_back(phase[first[i] + k]);
+        }
+        // phase is relative to the first member of the new group
+        g->setFecInv(phase[first[i] + k] != leadPhase[id]);
+        g->setFec(newGrp[i][id]);
+        newGrp[i][id]->push_back(g);
+      }
+    }
+  };
+  runSimThreads(_simThreads, signature);
+  runSimThreads(_simThreads, split);
 
-    for (int j = 0, n = _vDfsList.size(); j < n; ++j)
-    {
-      if (_vDfsList[j]->isAig())
-      {
-        size_t in0 = (_vDfsList[j]->fanin0_inv()) ? ~_vDfsList[j]->fanin0_gate()->getPattern() : _vDfsList[j]->fanin0_gate()->getPattern();
-        size_t in1 = (_vDfsList[j]->fanin1_inv()) ? ~_vDfsList[j]->fanin1_gate()->getPattern() : _vDfsList[j]->fanin1_gate()->getPattern();
-        size_t value = in0 & in1;
-        _vDfsList[j]->setPattern(value);
+  vector<vector<CirGate*>*> x;
+  for (size_t i = 0; i < c; ++i) {
+    delete _fecGrpList[i];
+    for (size_t k = 0, n = newGrp[i].size(); k < n; ++k) {
+      vector<CirGate*>* grp = newGrp[i][k];
+      if (grp->size() > 1)
+        x.push_back(grp);
+      else {
+        grp->at(0)->setFec(0);
+        delete grp;
       }
-      else if (_vDfsList[j]->isPo())
-      {
-        size_t value = (_vDfsList[j]->fanin0_inv()) ? ~_vDfsList[j]->fanin0_gate()->getPattern() : _vDfsList[j]->fanin0_gate()->getPattern();
-        _vDfsList[j]->setPattern(value);
+    }
+  }
+  _fecGrpList.swap(x);
+  _fecPhaseValid = true;
+}
+
+static inline size_t
+sigMix(size_t h)
+{
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+// Fold the words of "nBlk" blocks into the 128-bit signature of every slot.
+// Words are taken in the phase of the first pattern of the run, so a gate
+// and its complement get the same signature and the phase says which is
+// which; unlike the per-block phase of refineFecGrp() this is exact.
+void
+CirMgr::accumSig(size_t nBlk)
+{
+  size_t nSig = _simSigSlots.size();
+  size_t chunk = (nSig + _simThreads - 1) / _simThreads;
+  bool first = (_simSigBlks == 0);
+  runSimThreads(_simThreads, [&] (size_t t) {
+    for (size_t i = t * chunk, e = (i + chunk < nSig) ? i + chunk : nSig; i < e; ++i) {
+      size_t s = _simSigSlots[i];
+      size_t h0 = _simSig[2 * s], h1 = _simSig[2 * s + 1];
+      if (first) _simSigPhase[s] = simValue(0, s) & 1;
+      size_t m = _simSigPhase[s] ? ~size_t(0) : 0;
+      for (size_t b = 0; b < nBlk; ++b) {
+        size_t w = simValue(b, s) ^ m;
+        h0 = (h0 ^ w) * 0x9e3779b97f4a7c15ULL;
+        h0 ^= h0 >> 32;
+        h1 = (h1 + w) * 0xbf58476d1ce4e5b9ULL;
+        h1 ^= h1 >> 29;
       }
+      _simSig[2 * s] = h0;
+      _simSig[2 * s + 1] = h1;
     }
+  });
+  _simSigBlks += nBlk;
+}
 
-    if (_simLog)
-    {
-      size_t g = 0x1;
-      for (int i = 0, m = in[0].size(); i < m; ++i)
-      {
-        for (int j = 0; j < _nPI; ++j)
-        {
-          *_simLog << in[j][i];
-        }
-        *_simLog << " ";
-        for (int j = 0, n = _vAllGates.size(); j < n; ++j)
-        {
-          if (_vAllGates[j]->isPo())
-          {
-            if (g & _vAllGates[j]->getPattern())  *_simLog << "1";
-            else                                  *_simLog << "0";
-          }
-        }
-        g *= 2;
-        *_simLog << endl;
+// Only the slots of the FEC candidates are worth a signature
+void
+CirMgr::collectSigSlots()
+{
+  _simSigSlots.clear();
+  vector<bool> seen(_simNet.size() / 2, false);
+  for (size_t i = 0, c = _fecGrpList.size(); i < c; ++i)
+    for (size_t k = 0, n = _fecGrpList[i]->size(); k < n; ++k) {
+      CirGate* g = _fecGrpList[i]->at(k);
+      size_t slot = inDfs(g) ? g->dfsId() + 1 : 0;
+      if (!seen[slot]) {
+        seen[slot] = true;
+        _simSigSlots.push_back(slot);
       }
     }
+  sort(_simSigSlots.begin(), _simSigSlots.end());
+}
 
-    /////
-    size_t c = _fecGrpList.size();
-    for (int j = 0, n = _fecGrpList.size(); j < n; ++j)
-    {
-      if (_fecGrpList[j]->size() > 1)
-      {
-        HashMap<SimKey, vector<CirGate *> *> newfeclist(_fecGrpList[j]->size());
-        for (int k = 0, l = _fecGrpList[j]->size(); k < l; ++k)
-        {
-          if (_fecGrpList[j]->at(k)->isAig() || _fecGrpList[j]->at(k)->isConst())
-          {
-            SimKey newkey(_fecGrpList[j]->at(k)->getPattern());
-            SimKey i_newkey(~_fecGrpList[j]->at(k)->getPattern());
-            vector<CirGate *> *temp = 0;
-            if (newfeclist.query(newkey, temp))
-            {
-              _fecGrpList[j]->at(k)->setFec(temp);
-              _fecGrpList[j]->at(k)->setFecInv(false);
-              temp->push_back(_fecGrpList[j]->at(k));
-            }
-            else if (newfeclist.query(i_newkey, temp))
-            {
-              _fecGrpList[j]->at(k)->setFecInv(true);
-              _fecGrpList[j]->at(k)->setFec(temp);
-              temp->push_back(_fecGrpList[j]->at(k));
-            }
-            else
-            {
-              _fecGrpList[j]->at(k)->setFecInv(false);
-              temp = new vector<CirGate *>;
-              _fecGrpList[j]->at(k)->setFec(temp);
-              temp->push_back(_fecGrpList[j]->at(k));
-              _fecGrpList.push_back(temp);
-              newfeclist.insert(newkey, temp);
-            }
-          }
-        }
+// Split all the FEC groups by the accumulated signatures in one pass over
+// the candidates with a single hash. Gates stay together iff they were in
+// the same group, have the same signature and their phases agree with the
+// fec_inv they had; the signatures then start over.
+void
+CirMgr::regroupBySig()
+{
+  if (_simSigBlks == 0) return;
+  size_t nCand = 0;
+  for (size_t i = 0, c = _fecGrpList.size(); i < c; ++i)
+    nCand += _fecGrpList[i]->size();
+  HashMap<SimSigKey, size_t> grpOf(nCand ? nCand : 1);
+  vector<vector<CirGate*>*> newGrp;
+  vector<unsigned char> leadPhase;
+  for (size_t i = 0, c = _fecGrpList.size(); i < c; ++i) {
+    vector<CirGate*>* grp = _fecGrpList[i];
+    for (size_t k = 0, n = grp->size(); k < n; ++k) {
+      CirGate* g = grp->at(k);
+      size_t slot = inDfs(g) ? g->dfsId() + 1 : 0;
+      bool p = _simSigPhase[slot];
+      bool q = _fecPhaseValid && (p != g->getFecInv());
+      SimSigKey key(2 * i + q, sigMix(_simSig[2 * slot]), _simSig[2 * slot + 1]);
+      size_t id = size_t(-1);         // query() only reports data != id
+      if (!grpOf.query(key, id)) {
+        id = newGrp.size();
+        grpOf.insert(key, id);
+        newGrp.push_back(new vector<CirGate*>);
+        leadPhase.push_back(p);
       }
+      g->setFecInv(p != leadPhase[id]);
+      g->setFec(newGrp[id]);
+      newGrp[id]->push_back(g);
     }
-    vector<vector<CirGate *> *> x;
-    for (size_t k = c, l = _fecGrpList.size(); k < l; ++k)
-    {
-      if (_fecGrpList[k]->size() > 1)
-        x.push_back(_fecGrpList[k]);
+    delete grp;
+  }
+
+  _fecGrpList.clear();
+  for (size_t i = 0, n = newGrp.size(); i < n; ++i) {
+    if (newGrp[i]->size() > 1)
+      _fecGrpList.push_back(newGrp[i]);
+    else {
+      newGrp[i]->at(0)->setFec(0);
+      delete newGrp[i];
     }
-    _fecGrpList.clear();
-    _fecGrpList = x;
+  }
+  _fecPhaseValid = true;
+  fill(_simSig.begin(), _simSig.end(), 0);
+  _simSigBlks = 0;
+  collectSigSlots();
+  cout << "Total #FEC Group = " << _fecGrpList.size() << "\r";
+}
 
-    p += in[0].size();
+// Bring the simulation values up to date after netlist edits: only the
+// transitive fanouts of the gates whose fanins changed are re-evaluated, in
+// DFS order, and propagation stops wherever a value does not change.
+// Return the number of gates evaluated.
+size_t
+CirMgr::incrSim()
+{
+  auto later = [] (const CirGate* g1, const CirGate* g2) {
+    return g1->dfsId() > g2->dfsId();
+  };
+  vector<CirGate*>& dirty = _simDirtyList;
+  vector<CirGate*> heap;
+  ++globalRef;
+  for (size_t i = 0, n = dirty.size(); i < n; ++i) {
+    CirGate* g = dirty[i];
+    g->clearSimDirty();
+    if (_piPatValid && inDfs(g) && g->ref() != globalRef) {
+      g->setRef(globalRef);
+      heap.push_back(g);
+    }
+  }
+  dirty.clear();
+  make_heap(heap.begin(), heap.end(), later);
 
-    size_t size = 0;
-    for (int j = 0, n = _fecGrpList.size(); j < n; ++j)
-    {
-      if (_fecGrpList[j]->size() > 1)
-        size += 1;
+  size_t count = 0;
+  while (!heap.empty()) {
+    pop_heap(heap.begin(), heap.end(), later);
+    CirGate* g = heap.back();
+    heap.pop_back();
+    ++count;
+    size_t value = evalPattern(g);
+    if (value == g->getPattern()) continue;
+    g->setPattern(value);
+    for (unsigned i = 0, n = g->nFanouts(); i < n; ++i) {
+      CirGate* f = g->fanout_gate(i);
+      if (f->ref() == globalRef || !inDfs(f)) continue;
+      f->setRef(globalRef);
+      heap.push_back(f);
+      push_heap(heap.begin(), heap.end(), later);
     }
-    cout << "Total #FEC Group = " << size << "\r";
   }
+  return count;
+}
 
-  sort(_fecGrpList.begin(), _fecGrpList.end(), 
-        [] (const vector<CirGate*>* g1, const vector<CirGate*>* g2) {
-           return g1->at(0)->getVar() < g2->at(0)->getVar();
-        });
-  cout << p << " patterns simulated." << endl;
+// Fill "piPat" with the PI words of random round "round". Flips need
+// previous PI words: simBlock() left them on the PIs for round > 0, an
+// earlier simulation for round 0.
+void
+CirMgr::genPattern(SimPatGen gen, size_t round, vector<size_t>& piPat)
+{
+  if (gen == SIM_FLIP && round == 0 && !_piPatValid)
+    gen = SIM_UNIFORM;
+  switch (gen) {
+    case SIM_WEIGHT:
+    case SIM_SIGPROB:
+      for (size_t j = 0; j < _nPI; ++j)
+        piPat[j] = biasedWord(_piWeight[j]);
+      break;
+    case SIM_FLIP:
+      // pattern k is the previous pattern k with one PI flipped;
+      // successive rounds walk through the PIs
+      for (size_t j = 0; j < _nPI; ++j)
+        piPat[j] = _vPi[j]->getPattern();
+      for (size_t k = 0; k < 64 && _nPI; ++k)
+        piPat[(round * 64 + k) % _nPI] ^= (size_t)1 << k;
+      break;
+    default:
+      _simRnGen.fill(piPat);
+      break;
+  }
 }
 
-/*************************************************/
-/*   Private member functions about Simulation   */
-/*************************************************/
+// A word whose bits are 1 with probability "p" (in steps of 1/256):
+// fold uniform words in with AND/OR from the LSB of p's binary expansion
+size_t
+CirMgr::biasedWord(double p)
+{
+  int q = (int)(p * 256 + 0.5);
+  if (q <= 0)   return 0;
+  if (q >= 256) return ~(size_t)0;
+  int b = 0;
+  while (!(q & 1)) { q >>= 1; ++b; }
+  size_t w = 0;
+  for (; b < 8; ++b, q >>= 1)
+    w = (q & 1) ? (w | _simRnGen()) : (w & _simRnGen());
+  return w;
+}
 
+// Estimate signal probabilities under uniform PIs (every PI is 1 with
+// probability 0.5), then bias the PIs toward the rare value of the FEC
+// candidates that are (almost) constant
+void
+CirMgr::sigProbWeight()
+{
+  vector<double> prob(_vAllGates.size(), 0);
+  vector<int> piId(_vAllGates.size(), -1);
+  for (size_t j = 0; j < _nPI; ++j) {
+    prob[_vPi[j]->getVar()] = 0.5;
+    piId[_vPi[j]->getVar()] = j;
+  }
+  for (int j = 0, n = _vDfsList.size(); j < n; ++j) {
+    CirGate* g = _vDfsList[j];
+    if (!g->isAig()) continue;
+    double p0 = prob[g->fanin0_var()], p1 = prob[g->fanin1_var()];
+    prob[g->getVar()] = (g->fanin0_inv() ? 1 - p0 : p0) * (g->fanin1_inv() ? 1 - p1 : p1);
+  }
+
+  vector<int> vote(_nPI * 2, 0);   // [2j]: votes for 0, [2j+1]: votes for 1
+  for (size_t i = 0, n = _fecGrpList.size(); i < n; ++i) {
+    CirGate* g = 0;
+    double dist = 0.5;
+    for (size_t k = 0, s = _fecGrpList[i]->size(); k < s; ++k) {
+      CirGate* c = _fecGrpList[i]->at(k);
+      if (!c->isAig()) continue;
+      double d = prob[c->getVar()] < 0.5 ? prob[c->getVar()] : 1 - prob[c->getVar()];
+      if (d < dist) { dist = d; g = c; }
+    }
+    if (g && dist < 0.1)
+      backtrace(g, prob[g->getVar()] < 0.5, prob, piId, vote);
+  }
+
+  for (size_t j = 0; j < _nPI; ++j) {
+    double v0 = vote[2 * j], v1 = vote[2 * j + 1];
+    _piWeight[j] = 0.1 + 0.8 * (v1 + 1) / (v0 + v1 + 2);
+  }
+}
+
+// Walk from "g" toward the PIs, recording which PI values help g become
+// "val"; an AND needs both fanins for 1 but only its likeliest one for 0
+void
+CirMgr::backtrace(CirGate* g, bool val, const vector<double>& prob,
+                  vector<int>& piId, vector<int>& vote)
+{
+  static const size_t budget = 1024;
+  vector<pair<CirGate*, bool> > stack(1, make_pair(g, val));
+  size_t visited = 0;
+  ++globalRef;
+  while (!stack.empty() && visited < budget) {
+    CirGate* c = stack.back().first; bool v = stack.back().second;
+    stack.pop_back();
+    if (c->ref() == globalRef) continue;
+    c->setRef(globalRef);
+    ++visited;
+    if (piId[c->getVar()] >= 0) {
+      ++vote[2 * piId[c->getVar()] + v];
+      continue;
+    }
+    if (!c->isAig()) continue;
+    if (v) {
+      stack.push_back(make_pair(c->fanin0_gate(), !c->fanin0_inv()));
+      stack.push_back(make_pair(c->fanin1_gate(), !c->fanin1_inv()));
+    }
+    else {
+      double p0 = prob[c->fanin0_var()], p1 = prob[c->fanin1_var()];
+      p0 = c->fanin0_inv() ? 1 - p0 : p0;
+      p1 = c->fanin1_inv() ? 1 - p1 : p1;
+      if (p0 <= p1) stack.push_back(make_pair(c->fanin0_gate(), c->fanin0_inv()));
+      else          stack.push_back(make_pair(c->fanin1_gate(), c->fanin1_inv()));
+    }
+  }
+}
+
+// Check one line of the pattern file
+bool
+CirMgr::checkPattern(const string& pat) const
+{
+  if (pat.size() != _nPI) {
+    cerr << "\nError: Pattern(" << pat << ") length(" << pat.size() << ") does not match the number of inputs(" << _nPI << ") in a circuit!!" << endl;
+    return false;
+  }
+  for (size_t i = 0, s = pat.size(); i < s; ++i) {
+    if (pat[i] != '0' && pat[i] != '1') {
+      cerr << "\nError: Pattern(" << pat << ") contains a non-0/1 character(\'" << pat[i] << "\')." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Dump the first "n" patterns of the current block to _simLog.
+// The whole block is formatted into _simLogBuf and written at once.
+void
+CirMgr::writeSimLog(size_t n)
+{
+  _simLogWords.resize(_nPI + _nPO);
+  for (size_t j = 0; j < _nPI; ++j)
+    _simLogWords[j] = _vPi[j]->getPattern();
+  for (unsigned j = 0; j < _nPO; ++j)
+    _simLogWords[_nPI + j] = po(j)->getPattern();
+
+  if (_simLogBin) {
+    if (_simLog->tellp() == 0) {
+      LogFileHeader h;
+      memcpy(h.magic, logMagic, sizeof(logMagic));
+      h.nPI = _nPI; h.nPO = _nPO;
+      _simLog->write((const char*)&h, sizeof(h));
+    }
+    _simLog->write((const char*)&n, sizeof(n));
+    _simLog->write((const char*)&_simLogWords[0], _simLogWords.size() * sizeof(size_t));
+    return;
+  }
+
+  initBitChars();
+  size_t lineLen = _nPI + _nPO + 2;
+  _simLogBuf.resize(n * lineLen);
+  char* buf = &_simLogBuf[0];
+  for (size_t k = 0; k < n; ++k) {
+    buf[k * lineLen + _nPI] = ' ';
+    buf[k * lineLen + lineLen - 1] = '\n';
+  }
+  formatBits(&_simLogWords[0], _nPI, n, buf, lineLen);
+  formatBits(&_simLogWords[_nPI], _nPO, n, buf + _nPI + 1, lineLen);
+  _simLog->write(buf, n * lineLen);
+}
@@ -27,15 +27,26 @@ int effLimit = INT_MAX;
 // Helper functions:
 
 
-void removeWatch(vec<Clause*>& ws, Clause* elem)
+void removeWatch(vec<Watcher>& ws, CRef elem)
 {
     if (ws.size() == 0) return;     // (skip lists that are already cleared)
     int j = 0;
-    for (; ws[j] != elem  ; j++) assert(j < ws.size());
+    for (; ws[j].cref != elem; j++) assert(j < ws.size());
     for (; j < ws.size()-1; j++) ws[j] = ws[j+1];
     ws.pop();
 }
 
+// Remove one implication 'q' from 'ws'; return FALSE if the list does not hold it.
+static bool removeBinWatch(vec<Lit>& ws, Lit q)
+{
+    int j = 0;
+    while (j < ws.size() && !(ws[j] == q)) j++;
+    if (j == ws.size()) return false;
+    for (; j < ws.size()-1; j++) ws[j] = ws[j+1];
+    ws.pop();
+    return true;
+}
+
 
 //=================================================================================================
 // Operations on clauses:
@@ -56,11 +67,12 @@ void removeWatch(vec<Clause*>& ws, Clause* elem)
 |             literal. One of the watches will always be on this literal, the other will be set to
 |             the literal with the highest decision level.
 |    id     - If logging proof, learnt clauses should be given an ID by caller.
+|    lbd    - The literal block distance of a learnt clause (see 'computeLBD()').
 |  
 |  Effect:
 |    Activity heuristics are updated.
 |________________________________________________________________________________________________@*/
-void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
+void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A, int lbd)
 {
     assert(learnt || id == ClauseId_NULL);
     if (!ok) return;
@@ -72,6 +84,7 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
 
         // Remove duplicates:
         sortUnique(qs);
+        for (int i = 0; i < qs.size(); i++) assert(!eliminated[var(qs[i])]);
 
         // Check if clause is satisfied:
         for (int i = 0; i < qs.size()-1; i++){
@@ -104,9 +117,21 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
         if (!enqueue(ps[0]))
             ok = false;
 
+    }else if (ps.size() == 2 && proof == NULL){
+        // Binary clause: no clause object, just an implication each way (never removed):
+        bin_watches[index(~ps[0])].push(ps[1]);
+        bin_watches[index(~ps[1])].push(ps[0]);
+        n_bin_clauses++;
+        if (learnt){
+            check(enqueue(ps[0], GClause_new(ps[1])));
+            stats.learnts_literals += 2;
+        }else
+            stats.clauses_literals += 2;
+
     }else{
         // Allocate clause:
-        Clause* c   = Clause_new(learnt, ps, id);
+        CRef    cr  = ca.alloc(ps, learnt, id);
+        Clause& c   = ca[cr];
 
         if (learnt){
             // Put the second watch on the literal with highest decision level:
@@ -116,47 +141,48 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
                 if (level[var(ps[i])] > max)
                     max   = level[var(ps[i])],
                     max_i = i;
-            (*c)[1]     = ps[max_i];
-            (*c)[max_i] = ps[1];
+            c[1]     = ps[max_i];
+            c[max_i] = ps[1];
 
             // Bumping:
             claBumpActivity(c); // (newly learnt clauses should be considered active)
+            c.lbd() = lbd;
 
             // Enqueue asserting literal:
-            check(enqueue((*c)[0], c));
+            check(enqueue(c[0], GClause_new(cr)));
 
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            learnts.push(c);
-            stats.learnts_literals += c->size();
+            watches[index(~c[0])].push(Watcher(cr, c[1]));
+            watches[index(~c[1])].push(Watcher(cr, c[0]));
+            learnts.push(cr);
+            stats.learnts_literals += c.size();
 
         }else{
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            clauses.push(c);
-            stats.clauses_literals += c->size();
+            watches[index(~c[0])].push(Watcher(cr, c[1]));
+            watches[index(~c[1])].push(Watcher(cr, c[0]));
+            clauses.push(cr);
+            stats.clauses_literals += c.size();
         }
     }
 }
 
 
 // Disposes a clauses and removes it from watcher lists. NOTE! Low-level; does NOT change the 'clauses' and 'learnts' vector.
+// The memory is reclaimed by the next 'garbageCollect()'.
 //
-void Solver::remove(Clause* c, bool just_dealloc)
+void Solver::remove(CRef cr)
 {
-    if (!just_dealloc){
-        removeWatch(watches[index(~(*c)[0])], c),
-        removeWatch(watches[index(~(*c)[1])], c);
+    Clause& c = ca[cr];
+    removeWatch(watches[index(~c[0])], cr),
+    removeWatch(watches[index(~c[1])], cr);
 
-        if (c->learnt()) stats.learnts_literals -= c->size();
-        else             stats.clauses_literals -= c->size();
+    if (c.learnt()) stats.learnts_literals -= c.size();
+    else            stats.clauses_literals -= c.size();
 
-        if (proof != NULL) proof->deleted(c->id());
-    }
+    if (proof != NULL) proof->deleted(c.id());
 
-    xfree(c);
+    ca.free(cr);
 }
 
 
@@ -164,11 +190,12 @@ void Solver::remove(Clause* c, bool just_dealloc)
 // the clause is binary and satisfied, in which case the first literal is true)
 // Returns True if clause is satisfied (will be removed), False otherwise.
 //
-bool Solver::simplify(Clause* c) const
+bool Solver::simplify(CRef cr) const
 {
     assert(decisionLevel() == 0);
-    for (int i = 0; i < c->size(); i++){
-        if (value((*c)[i]) == l_True)
+    const Clause& c = ca[cr];
+    for (int i = 0; i < c.size(); i++){
+        if (value(c[i]) == l_True)
             return true;
     }
     return false;
@@ -187,13 +214,19 @@ Var Solver::newVar() {
     index = nVars();
     watches     .push();          // (list for positive literal)
     watches     .push();          // (list for negative literal)
-    reason      .push(NULL);
+    bin_watches .push();
+    bin_watches .push();
+    reason      .push(GClause_NULL);
     assigns     .push(toInt(l_Undef));
     level       .push(-1);
     trail_pos   .push(-1);
     activity    .push(0);
+    polarity    .push(1);
+    frozen      .push(0);
+    eliminated  .push(0);
     order       .newVar();
     analyze_seen.push(0);
+    lbd_seen    .growTo(index+2, 0);  // (levels go from 0 to 'nVars()')
     if (proof != NULL) unit_id.push(ClauseId_NULL);
     return index; }
 
@@ -210,7 +243,8 @@ void Solver::cancelUntil(int level) {
         for (int c = trail.size()-1; c >= trail_lim[level]; c--){
             Var     x  = var(trail[c]);
             assigns[x] = toInt(l_Undef);
-            reason [x] = NULL;
+            reason [x] = GClause_NULL;
+            if (phase_saving) polarity[x] = sign(trail[c]);
             order.undo(x); }
         trail.shrink(trail.size() - trail_lim[level]);
         trail_lim.shrink(trail_lim.size() - level);
@@ -223,7 +257,7 @@ void Solver::cancelUntil(int level) {
 
 /*_________________________________________________________________________________________________
 |
-|  analyze : (confl : Clause*) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
+|  analyze : (confl : CRef) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
 |  
 |  Description:
 |    Analyze conflict and produce a reason clause ('out_learnt') and a backtracking level
@@ -244,7 +278,7 @@ public:
     lastToFirst_lt(const vec<int>& t) : trail_pos(t) {}
     bool operator () (Lit p, Lit q) { return trail_pos[var(p)] > trail_pos[var(q)]; }
 };
-void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
+void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
 {
     vec<char>&     seen  = analyze_seen;
     int            pathC = 0;
@@ -252,16 +286,22 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
     // Generate conflict clause:
     //
-    if (proof != NULL) proof->beginChain(confl->id());
+    if (proof != NULL) proof->beginChain(ca[confl].id());
     out_learnt.push();          // (leave room for the asserting literal)
     out_btlevel = 0;
     int index = trail.size()-1;
     for(;;){
-        assert(confl != NULL);  // (otherwise should be UIP)
-
-        Clause& c = *confl;
-        if (c.learnt())
-            claBumpActivity(&c);
+        assert(confl != CRef_Undef);    // (otherwise should be UIP)
+
+        Clause& c = ca[confl];
+        if (c.learnt()){
+            claBumpActivity(c);
+            if (lbd_reduce && c.lbd() > 2){
+                // Clauses that keep taking part in conflicts may have become tighter:
+                uint lbd = computeLBD(&c[0], c.size());
+                if (lbd < c.lbd()) c.lbd() = lbd;
+            }
+        }
 
         for (int j = (p == lit_Undef) ? 0 : 1; j < c.size(); j++){
             Lit q = c[j];
@@ -283,12 +323,12 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         // Select next clause to look at:
         while (!seen[var(trail[index--])]);
         p     = trail[index+1];
-        confl = reason[var(p)];
+        confl = reasonClause(var(p));
         seen[var(p)] = 0;
         pathC--;
         if (pathC == 0) break;
 
-        if (proof != NULL) proof->resolve(confl->id(), ~p);
+        if (proof != NULL) proof->resolve(ca[confl].id(), ~p);
     }
     out_learnt[0] = ~p;
 
@@ -304,18 +344,17 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++)
-            if (reason[var(out_learnt[i])] == NULL || !analyze_removable(out_learnt[i], min_level))
+            if (reason[var(out_learnt[i])] == GClause_NULL || !analyze_removable(out_learnt[i], min_level))
                 out_learnt[j++] = out_learnt[i];
     }else if(expensive_ccmin == 1){
         // Simplify conflict clause (a little):
         //
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++){
-            Clause* r = reason[var(out_learnt[i])];
-            if (r == NULL)
+            if (reason[var(out_learnt[i])] == GClause_NULL)
                 out_learnt[j++] = out_learnt[i];
             else{
-                Clause& c = *r;
+                Clause& c = ca[reasonClause(var(out_learnt[i]))];
                 for (int k = 1; k < c.size(); k++)
                     if (!seen[var(c[k])] && level[var(c[k])] != 0){
                         out_learnt[j++] = out_learnt[i];
@@ -334,7 +373,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         for (int k = 0; k < analyze_toclear.size(); k++){
             Var     v = var(analyze_toclear[k]); assert(level[v] > 0);
 				Lit     l = analyze_toclear[k];
-            Clause& c = *reason[v];
+            Clause& c = ca[reason[v].clause()];  // (no binary reasons when logging proofs)
             proof->resolve(c.id(), l);
             for (int k = 1; k < c.size(); k++)
                 if (level[var(c[k])] == 0)
@@ -357,17 +396,17 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 //
 bool Solver::analyze_removable(Lit p, uint min_level)
 {
-    assert(reason[var(p)] != NULL);
+    assert(reason[var(p)] != GClause_NULL);
     analyze_stack.clear(); analyze_stack.push(p);
     int top = analyze_toclear.size();
     while (analyze_stack.size() > 0){
-        assert(reason[var(analyze_stack.last())] != NULL);
-        Clause& c = *reason[var(analyze_stack.last())];
+        assert(reason[var(analyze_stack.last())] != GClause_NULL);
+        Clause& c = ca[reasonClause(var(analyze_stack.last()))];
         analyze_stack.pop();
         for (int i = 1; i < c.size(); i++){
             Lit p = c[i];
             if (!analyze_seen[var(p)] && level[var(p)] != 0){
-                if (reason[var(p)] != NULL && ((1 << (level[var(p)] & 31)) & min_level) != 0){
+                if (reason[var(p)] != GClause_NULL && ((1 << (level[var(p)] & 31)) & min_level) != 0){
                     analyze_seen[var(p)] = 1;
                     analyze_stack.push(p);
                     analyze_toclear.push(p);
@@ -388,7 +427,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 
 /*_________________________________________________________________________________________________
 |
-|  analyzeFinal : (confl : Clause*) (skip_first : bool)  ->  [void]
+|  analyzeFinal : (confl : CRef) (skip_first : bool)  ->  [void]
 |  
 |  Description:
 |    Specialized analysis procedure to express the final conflict in terms of assumptions.
@@ -396,7 +435,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 |    making assumptions). If 'skip_first' is TRUE, the first literal of 'confl' is  ignored (needed
 |    if conflict arose before search even started).
 |________________________________________________________________________________________________@*/
-void Solver::analyzeFinal(Clause* confl, bool skip_first)
+void Solver::analyzeFinal(CRef confl, bool skip_first)
 {
     // -- NOTE! This code is relatively untested. Please report bugs!
     conflict.clear();
@@ -405,10 +444,10 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         return; }
    //assert(false);
     vec<char>&     seen  = analyze_seen;
-    if (proof != NULL) proof->beginChain(confl->id());
-    for (int i = skip_first ? 1 : 0; i < confl->size(); i++){
-        Var     x = var((*confl)[i]);
-		  Lit		 l = (*confl)[i];
+    if (proof != NULL) proof->beginChain(ca[confl].id());
+    for (int i = skip_first ? 1 : 0; i < ca[confl].size(); i++){
+        Var     x = var(ca[confl][i]);
+		  Lit		 l = ca[confl][i];
         if (level[x] > 0)
             seen[x] = 1;
         else
@@ -420,12 +459,11 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         Var     x = var(trail[i]);
 		  Lit     l = trail[i];
         if (seen[x]){
-            Clause* r = reason[x];
-            if (r == NULL){
+            if (reason[x] == GClause_NULL){
                 assert(level[x] > 0);
                 conflict.push(~trail[i]);
             }else{
-                Clause& c = *r;
+                Clause& c = ca[reasonClause(x)];
                 if (proof != NULL) proof->resolve(c.id(), l);
                 for (int j = 1; j < c.size(); j++)
                     if (level[var(c[j])] > 0)
@@ -442,7 +480,7 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 
 /*_________________________________________________________________________________________________
 |
-|  enqueue : (p : Lit) (from : Clause*)  ->  [bool]
+|  enqueue : (p : Lit) (from : GClause)  ->  [bool]
 |  
 |  Description:
 |    Puts a new fact on the propagation queue as well as immediately updating the variable's value.
@@ -451,12 +489,12 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 |  Input:
 |    p    - The fact to enqueue
 |    from - [Optional] Fact propagated from this (currently) unit clause. Stored in 'reason[]'.
-|           Default value is NULL (no reason).
+|           Default value is NULL (no reason). A binary clause is given by its other literal.
 |  
 |  Output:
 |    TRUE if fact was enqueued without conflict, FALSE otherwise.
 |________________________________________________________________________________________________@*/
-bool Solver::enqueue(Lit p, Clause* from)
+bool Solver::enqueue(Lit p, GClause from)
 {
     if (value(p) != l_Undef)
         return value(p) != l_False;
@@ -475,28 +513,47 @@ bool Solver::enqueue(Lit p, Clause* from)
 
 /*_________________________________________________________________________________________________
 |
-|  propagate : [void]  ->  [Clause*]
+|  propagate : [void]  ->  [CRef]
 |  
 |  Description:
 |    Propagates all enqueued facts. If a conflict arises, the conflicting clause is returned,
-|    otherwise NULL. NOTE! This method has been optimized for speed rather than readability.
+|    otherwise CRef_Undef. NOTE! This method has been optimized for speed rather than readability.
 |  
 |    Post-conditions:
 |      * The propagation queue is empty, even if there was a conflict.
 |________________________________________________________________________________________________@*/
-Clause* Solver::propagate()
+CRef Solver::propagate()
 {
-    Clause* confl = NULL;
+    CRef    confl = CRef_Undef;
     while (qhead < trail.size()){
         stats.propagations++;
         simpDB_props--;
 
         Lit            p  = trail[qhead++];     // 'p' is enqueued fact to propagate.
-        vec<Clause*>&  ws = watches[index(p)];
-        Clause**       i,** j,** end;
 
-        for (i = j = (Clause**)ws, end = i + ws.size();  i != end;){
-            Clause& c = **i; i++;
+        // Binary clauses first; they need no clause memory at all:
+        vec<Lit>&      bs = bin_watches[index(p)];
+        for (int k = 0; k < bs.size(); k++){
+            Lit q = bs[k];
+            if (!enqueue(q, GClause_new(~p))){
+                if (decisionLevel() == 0)
+                    ok = false;
+                confl = propagate_tmpbin;
+                ca[confl][0] = q; ca[confl][1] = ~p;
+                qhead = trail.size();
+                return confl; }
+        }
+
+        vec<Watcher>&  ws = watches[index(p)];
+        Watcher        *i, *j, *end;
+
+        for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
+            // Skip the clause if the blocker is true, without looking at it:
+            if (value(i->blocker) == l_True){
+                *j++ = *i++; continue; }
+
+            CRef    cr = i->cref;
+            Clause& c  = ca[cr]; i++;
             // Make sure the false literal is data[1]:
             Lit false_lit = ~p;
             if (c[0] == false_lit)
@@ -508,13 +565,13 @@ Clause* Solver::propagate()
             Lit   first = c[0];
             lbool val   = value(first);
             if (val == l_True){
-                *j++ = &c;
+                *j++ = Watcher(cr, first);
             }else{
                 // Look for new watch:
                 for (int k = 2; k < c.size(); k++)
                     if (value(c[k]) != l_False){
                         c[1] = c[k]; c[k] = false_lit;
-                        watches[index(~c[1])].push(&c);
+                        watches[index(~c[1])].push(Watcher(cr, first));
                         goto FoundWatch; }
 
                 // Did not find watch -- clause is unit under assignment:
@@ -535,11 +592,11 @@ Clause* Solver::propagate()
                     }
                 }
 					 
-                *j++ = &c;
-                if (!enqueue(first, &c)){
+                *j++ = Watcher(cr, first);
+                if (!enqueue(first, GClause_new(cr))){
                     if (decisionLevel() == 0)
                         ok = false;
-                    confl = &c;
+                    confl = cr;
                     qhead = trail.size();
                     // Copy the remaining watches:
                     while (i < end)
@@ -562,27 +619,114 @@ Clause* Solver::propagate()
 |  Description:
 |    Remove half of the learnt clauses, minus the clauses locked by the current assignment. Locked
 |    clauses are clauses that are reason to some assignment. Binary clauses are never removed.
+|    With 'lbd_reduce', the half with the largest LBDs goes instead, and clauses of LBD <= 2 stay.
 |________________________________________________________________________________________________@*/
-struct reduceDB_lt { bool operator () (Clause* x, Clause* y) { return x->size() > 2 && (y->size() == 2 || x->activity() < y->activity()); } };
+// Return the literal block distance of the (assigned) literals 'ps[0..size-1]': the number of
+// distinct decision levels among them. Clauses of few levels ("glue" clauses, LBD <= 2) tend to
+// stay useful.
+//
+int Solver::computeLBD(const Lit* ps, int size)
+{
+    if (++lbd_stamp == 0){      // (wrapped around: stale stamps could match)
+        for (int i = 0; i < lbd_seen.size(); i++) lbd_seen[i] = 0;
+        lbd_stamp = 1; }
+    int n = 0;
+    for (int i = 0; i < size; i++){
+        int l = level[var(ps[i])];
+        if (lbd_seen[l] != lbd_stamp)
+            lbd_seen[l] = lbd_stamp, n++;
+    }
+    return n;
+}
+
+
+struct reduceDB_lt {
+    const ClauseAllocator& ca;
+    reduceDB_lt(const ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) { return ca[x].size() > 2 && (ca[y].size() == 2 || ca[x].activity() < ca[y].activity()); } };
+struct reduceDB_lbd_lt {
+    const ClauseAllocator& ca;
+    reduceDB_lbd_lt(const ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) {
+        if (ca[x].lbd() != ca[y].lbd()) return ca[x].lbd() > ca[y].lbd();
+        return ca[x].activity() < ca[y].activity(); } };
 void Solver::reduceDB()
 {
     int     i, j;
     double  extra_lim = cla_inc / learnts.size();    // Remove any clause below this activity
 
-    sort(learnts, reduceDB_lt());
+    if (lbd_reduce){
+        // Glue clauses stay for good; of the others, drop the half with the largest LBDs:
+        sort(learnts, reduceDB_lbd_lt(ca));
+        for (i = j = 0; i < learnts.size(); i++){
+            if (i < learnts.size() / 2 && ca[learnts[i]].lbd() > 2 && !locked(learnts[i]))
+                remove(learnts[i]);
+            else
+                learnts[j++] = learnts[i];
+        }
+        learnts.shrink(i - j);
+        checkGarbage();
+        return;
+    }
+
+    sort(learnts, reduceDB_lt(ca));
     for (i = j = 0; i < learnts.size() / 2; i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]))
+        if (ca[learnts[i]].size() > 2 && !locked(learnts[i]))
             remove(learnts[i]);
         else
             learnts[j++] = learnts[i];
     }
     for (; i < learnts.size(); i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]) && learnts[i]->activity() < extra_lim)
+        if (ca[learnts[i]].size() > 2 && !locked(learnts[i]) && ca[learnts[i]].activity() < extra_lim)
             remove(learnts[i]);
         else
             learnts[j++] = learnts[i];
     }
     learnts.shrink(i - j);
+    checkGarbage();
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  garbageCollect : [void]  ->  [void]
+|  
+|  Description:
+|    Compact the clause arena: copy the live clauses into a fresh one, in the order the watcher
+|    lists meet them (so clauses watched together sit together), and update every reference --
+|    watchers, reasons of the current assignment, the clause lists and the temporary binaries.
+|    Removed clauses are already gone from the watcher lists, so nothing else points at them.
+|    'checkGarbage()' does this once more than a fifth of the arena is wasted.
+|________________________________________________________________________________________________@*/
+void Solver::checkGarbage()
+{
+    if (ca.wasted() > ca.size() / 5)
+        garbageCollect();
+}
+
+void Solver::garbageCollect()
+{
+    ClauseAllocator to(ca.size() - ca.wasted());
+
+    for (int i = 0; i < watches.size(); i++){
+        vec<Watcher>& ws = watches[i];
+        for (int j = 0; j < ws.size(); j++)
+            ca.reloc(ws[j].cref, to);
+    }
+    for (int i = 0; i < trail.size(); i++){
+        GClause& r = reason[var(trail[i])];
+        if (r != GClause_NULL && !r.isLit()){
+            CRef cr = r.clause();
+            ca.reloc(cr, to);
+            r = GClause_new(cr);
+        }
+    }
+    for (int i = 0; i < learnts.size(); i++) ca.reloc(learnts[i], to);
+    for (int i = 0; i < clauses.size(); i++) ca.reloc(clauses[i], to);
+    ca.reloc(propagate_tmpbin, to);
+    ca.reloc(analyze_tmpbin, to);
+
+    to.moveTo(ca);
 }
 
 
@@ -599,23 +743,32 @@ void Solver::simplifyDB()
     if (!ok) return;    // GUARD (public method)
     assert(decisionLevel() == 0);
 
-    if (propagate() != NULL){
+    if (propagate() != CRef_Undef){
         ok = false;
         return; }
 
     if (nAssigns() == simpDB_assigns || simpDB_props > 0)   // (nothing has changed or preformed a simplification too recently)
         return;
 
-    // Clear watcher lists:
+    // Clear watcher lists (every binary clause on a top-level variable is satisfied after
+    // 'propagate()'; the clause is dropped from its other list too, and counted once):
     for (int i = simpDB_assigns; i < nAssigns(); i++){
         Lit p = trail[i];
         watches[index( p)].clear(true);
         watches[index(~p)].clear(true);
+        for (int s = 0; s < 2; s++){
+            Lit       x  = s ? ~p : p;
+            vec<Lit>& bs = bin_watches[index(x)];
+            for (int k = 0; k < bs.size(); k++)
+                if (removeBinWatch(bin_watches[index(~bs[k])], ~x))
+                    n_bin_clauses--;
+            bs.clear(true);
+        }
     }
 
     // Remove satisfied clauses:
     for (int type = 0; type < 2; type++){
-        vec<Clause*>& cs = type ? learnts : clauses;
+        vec<CRef>&    cs = type ? learnts : clauses;
         int           j  = 0;
         for (int i = 0; i < cs.size(); i++){
             if (!locked(cs[i]) && simplify(cs[i]))
@@ -625,12 +778,281 @@ void Solver::simplifyDB()
         }
         cs.shrink(cs.size()-j);
     }
+    checkGarbage();
 
     simpDB_assigns = nAssigns();
     simpDB_props   = stats.clauses_literals + stats.learnts_literals;   // (shouldn't depend on 'stats' really, but it will do for now)
 }
 
 
+//=================================================================================================
+// Preprocessing (SatELite):
+
+
+// The clause set 'eliminate()' works on: sorted literal vectors with occurrence lists.
+struct ElimSet {
+    vec<vec<Lit> >  cs;         // The clauses (empty if removed).
+    vec<vec<int> >  occ;        // 'occ[index(p)]' lists the clauses containing 'p' (may list removed ones).
+    vec<int>        touched;    // Clauses to check for subsumption.
+    vec<char>       mark;       // Scratch, by 'index(p)'.
+    bool            empty;      // Set when strengthening derives the empty clause.
+
+    ElimSet(int n_vars) : empty(false) { occ.growTo(2*n_vars); mark.growTo(2*n_vars, 0); }
+
+    bool alive(int i) const { return cs[i].size() > 0; }
+    void add(const vec<Lit>& ps) {
+        int i = cs.size();
+        cs.push(); ps.copyTo(cs[i]);
+        for (int k = 0; k < ps.size(); k++) occ[index(ps[k])].push(i);
+        touched.push(i); }
+    void kill(int i) { cs[i].clear(true); }
+    void strengthen(int i, Lit p) {     // Remove 'p' from clause 'i'.
+        vec<Lit>& c = cs[i];
+        int k = 0;
+        while (c[k] != p) k++;
+        for (; k < c.size()-1; k++) c[k] = c[k+1];
+        c.pop();
+        if (c.size() == 0) empty = true;
+        vec<int>& os = occ[index(p)];
+        for (k = 0; os[k] != i; k++);
+        os[k] = os.last(); os.pop();
+        touched.push(i); }
+};
+
+
+// Check clause 'c' against the (longer) clause 'd': returns 'lit_Undef' if 'c' subsumes 'd', the
+// literal 'p' of 'd' to remove if 'c' with '~p' in place of 'p' subsumes 'd' (self-subsuming
+// resolution), and 'lit_Error' otherwise.
+static Lit subsumes(const vec<Lit>& c, const vec<Lit>& d, vec<char>& mark)
+{
+    for (int i = 0; i < d.size(); i++) mark[index(d[i])] = 1;
+    Lit ret = lit_Undef;
+    for (int i = 0; i < c.size() && ret != lit_Error; i++){
+        if (mark[index(c[i])]) continue;
+        ret = (ret == lit_Undef && mark[index(~c[i])]) ? ~c[i] : lit_Error;
+    }
+    for (int i = 0; i < d.size(); i++) mark[index(d[i])] = 0;
+    return ret;
+}
+
+
+// Resolve 'c' and 'd' (sorted) on 'v' into 'out' (sorted). Returns FALSE if the resolvent is a tautology.
+static bool resolve(const vec<Lit>& c, const vec<Lit>& d, Var v, vec<Lit>& out)
+{
+    out.clear();
+    int i = 0, j = 0;
+    while (i < c.size() || j < d.size()){
+        Lit p;
+        if      (j == d.size() || (i < c.size() && c[i] < d[j])) p = c[i++];
+        else if (i == c.size() || d[j] < c[i])                   p = d[j++];
+        else                                                      p = c[i++], j++;
+        if (var(p) == v) continue;
+        if (out.size() > 0 && out.last() == ~p) return false;
+        out.push(p);
+    }
+    return true;
+}
+
+
+// Remove the subsumed clauses and strengthen the others, starting from the 'touched' ones.
+static void backwardSubsume(ElimSet& s)
+{
+    while (s.touched.size() > 0){
+        int i = s.touched.last(); s.touched.pop();
+        if (!s.alive(i)) continue;
+        const vec<Lit>& c = s.cs[i];
+        // Candidates contain the variable of 'c' with the fewest occurrences:
+        Lit best = c[0];
+        for (int k = 1; k < c.size(); k++)
+            if (s.occ[index(c[k])].size() + s.occ[index(~c[k])].size() < s.occ[index(best)].size() + s.occ[index(~best)].size())
+                best = c[k];
+        for (int sgn = 0; sgn < 2; sgn++){
+            vec<int>& os = s.occ[index(sgn ? ~best : best)];
+            for (int k = 0; k < os.size() && s.alive(i); k++){
+                int j = os[k];
+                if (j == i || !s.alive(j) || s.cs[j].size() < c.size()) continue;
+                Lit p = subsumes(c, s.cs[j], s.mark);
+                if (p == lit_Undef)
+                    s.kill(j);
+                else if (p != lit_Error){
+                    s.strengthen(j, p);
+                    if (index(p) == index(sgn ? ~best : best)) k--;    // ('os' lost entry 'k')
+                }
+            }
+        }
+    }
+}
+
+
+class elimCost_lt {
+    const vec<int>& cost;
+public:
+    elimCost_lt(const vec<int>& c) : cost(c) {}
+    bool operator () (Var x, Var y) { return cost[x] < cost[y]; }
+};
+
+/*_________________________________________________________________________________________________
+|
+|  eliminate : [void]  ->  [bool]
+|
+|  Description:
+|    Shrink the problem clauses before the first search: subsumption, self-subsuming resolution
+|    and bounded variable elimination of every variable that is not 'frozen'. A variable is
+|    eliminated if no resolvent is longer than 'elim_clause_lim' and the resolvents are no more
+|    than the clauses they replace. Eliminated variables must not appear in later clauses or
+|    assumptions; they are never decided, and 'extendModel()' gives them values in a model.
+|    Learnt clauses are dropped. Not available with proof logging. Returns FALSE if the problem
+|    is found unsatisfiable.
+|________________________________________________________________________________________________@*/
+bool Solver::eliminate()
+{
+    static const int elim_clause_lim = 20;
+    if (!ok || proof != NULL) return ok;
+    assert(decisionLevel() == 0);
+    if (propagate() != CRef_Undef){
+        ok = false;
+        return false; }
+
+    // Move the problem clauses, reduced by the top-level assignment, out of the solver:
+    ElimSet     s(nVars());
+    vec<Lit>    ps;
+    for (int i = 0; i < clauses.size(); i++){
+        const Clause& c = ca[clauses[i]];
+        bool sat = false;
+        ps.clear();
+        for (int k = 0; k < c.size() && !sat; k++){
+            if      (value(c[k]) == l_True)  sat = true;
+            else if (value(c[k]) == l_Undef) ps.push(c[k]);
+        }
+        if (!sat){ sort(ps); s.add(ps); }
+        ca.free(clauses[i]);
+    }
+    for (int i = 0; i < 2*nVars(); i++){
+        Lit p = ~toLit(i);      // (the binary clauses are ('p', 'q') for 'q' in 'bin_watches[~p]')
+        if (value(p) != l_Undef) continue;
+        for (int k = 0; k < bin_watches[i].size(); k++){
+            Lit q = bin_watches[i][k];
+            if (index(p) < index(q) && value(q) == l_Undef){
+                ps.clear(); ps.push(p); ps.push(q);
+                s.add(ps); }
+        }
+    }
+    for (int i = 0; i < learnts.size(); i++) ca.free(learnts[i]);
+    clauses.clear(); learnts.clear();
+    for (int i = 0; i < 2*nVars(); i++){ watches[i].clear(true); bin_watches[i].clear(true); }
+    n_bin_clauses = 0;
+    stats.clauses_literals = stats.learnts_literals = 0;
+    for (int i = 0; i < trail.size(); i++) reason[var(trail[i])] = GClause_NULL;
+
+    backwardSubsume(s);
+    if (s.empty){
+        ok = false;
+        return false; }
+
+    // Eliminate the cheapest variables first (by the number of resolution steps):
+    vec<Var>    order_elim;
+    vec<int>    cost(nVars(), 0);
+    for (Var v = 0; v < nVars(); v++)
+        if (!frozen[v] && !eliminated[v] && value(v) == l_Undef){
+            cost[v] = s.occ[index(Lit(v))].size() * s.occ[index(~Lit(v))].size();
+            order_elim.push(v); }
+    sort(order_elim, elimCost_lt(cost));
+
+    vec<int>        pos, neg;
+    vec<vec<Lit> >  resolvents;
+    for (int e = 0; e < order_elim.size(); e++){
+        Var v = order_elim[e];
+        pos.clear(); neg.clear();
+        for (int sgn = 0; sgn < 2; sgn++){
+            const vec<int>& os = s.occ[index(Lit(v, sgn))];
+            for (int k = 0; k < os.size(); k++)
+                if (s.alive(os[k])) (sgn ? neg : pos).push(os[k]);
+        }
+        if (pos.size() + neg.size() == 0) continue;
+
+        // Collect the non-tautological resolvents, giving up if they are too many or too long:
+        int  n_res = 0;
+        bool fits  = true;
+        for (int i = 0; i < pos.size() && fits; i++)
+            for (int j = 0; j < neg.size() && fits; j++){
+                if (n_res == resolvents.size()) resolvents.push();
+                if (!resolve(s.cs[pos[i]], s.cs[neg[j]], v, resolvents[n_res])) continue;
+                fits = ++n_res <= pos.size() + neg.size() && resolvents[n_res-1].size() <= elim_clause_lim;
+            }
+        if (!fits) continue;
+
+        // Keep the clauses of the smaller side for 'extendModel()', with a default value for 'v':
+        vec<int>& keep = (pos.size() <= neg.size()) ? pos : neg;
+        for (int i = 0; i < keep.size(); i++){
+            const vec<Lit>& c = s.cs[keep[i]];
+            int first = elim_clauses.size();
+            for (int k = 0; k < c.size(); k++){
+                elim_clauses.push(index(c[k]));
+                if (var(c[k]) == v){ elim_clauses[k + first] = elim_clauses[first]; elim_clauses[first] = index(c[k]); }
+            }
+            elim_clauses.push(c.size());
+        }
+        elim_clauses.push(index(Lit(v, &keep == &pos)));
+        elim_clauses.push(1);
+
+        for (int i = 0; i < pos.size(); i++) s.kill(pos[i]);
+        for (int i = 0; i < neg.size(); i++) s.kill(neg[i]);
+        eliminated[v] = 1;
+        for (int i = 0; i < n_res; i++){
+            if (resolvents[i].size() == 0){
+                ok = false;
+                return false; }
+            s.add(resolvents[i]);
+        }
+        backwardSubsume(s);
+        if (s.empty){
+            ok = false;
+            return false; }
+    }
+
+    // Put the remaining clauses back:
+    for (int i = 0; i < s.cs.size() && ok; i++)
+        if (s.alive(i)) addClause(s.cs[i]);
+    checkGarbage();
+    return ok;
+}
+
+
+// Give the eliminated variables values that satisfy the clauses 'eliminate()' removed, in the
+// reverse order of elimination. A stored clause that no other literal satisfies sets its first
+// literal (the eliminated variable's).
+void Solver::extendModel()
+{
+    for (int i = elim_clauses.size()-1; i > 0; ){
+        int  n   = elim_clauses[i--];
+        bool sat = false;
+        for (; n > 1; n--, i--){
+            Lit p = toLit(elim_clauses[i]);
+            if (!sat && (sign(p) ? ~model[var(p)] : model[var(p)]) == l_True) sat = true;
+        }
+        Lit x = toLit(elim_clauses[i--]);
+        if (!sat) model[var(x)] = sign(x) ? l_False : l_True;
+    }
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  pickBranchLit : (params : const SearchParams&)  ->  [Lit]
+|
+|  Description:
+|    Pick the next decision: the variable from 'order' in the phase given by 'polarity'.
+|    Returns 'lit_Undef' if all variables are assigned.
+|________________________________________________________________________________________________@*/
+Lit Solver::pickBranchLit(const SearchParams& params)
+{
+    Var next = order.select(params.random_var_freq);
+    while (next != var_Undef && eliminated[next])
+        next = order.select(params.random_var_freq);
+    return next == var_Undef ? lit_Undef : Lit(next, polarity[next]);
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  search : (nof_conflicts : int) (nof_learnts : int) (params : const SearchParams&)  ->  [lbool]
@@ -654,11 +1076,12 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
     int     conflictC = 0;
     var_decay = 1 / params.var_decay;
     cla_decay = 1 / params.clause_decay;
+    lbd_reduce = params.lbd_reduce;
     model.clear();
 
     for (;;){
-        Clause* confl = propagate();
-        if (confl != NULL){
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             // CONFLICT
 
             stats.conflicts++; conflictC++;
@@ -669,8 +1092,14 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 analyzeFinal(confl);
                 return l_False; }
             analyze(confl, learnt_clause, backtrack_level);
+            int lbd = computeLBD(learnt_clause, learnt_clause.size());
+            lbd_count++;
+            lbd_fast += (lbd - lbd_fast) * max(1.0 / lbd_count, 1.0 / 32);
+            lbd_slow += (lbd - lbd_slow) * max(1.0 / lbd_count, 1.0 / 16384);
             cancelUntil(max(backtrack_level, root_level));
-            newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL);
+            newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL, true, lbd);
+            if (exchange != NULL && (learnt_clause.size() <= share_max_size || lbd <= share_max_lbd))
+                exchange->publish(exchange_id, learnt_clause, lbd);
             if (learnt_clause.size() == 1) level[var(learnt_clause[0])] = 0;    // (this is ugly (but needed for 'analyzeFinal()') -- in future versions, we will backtrack past the 'root_level' and redo the assumptions)
             varDecayActivity();
             claDecayActivity();
@@ -678,7 +1107,9 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
         }else{
             // NO CONFLICT
 
-            if (nof_conflicts >= 0 && conflictC >= nof_conflicts){
+            if ((nof_conflicts >= 0 && conflictC >= nof_conflicts)
+             || (params.restarts == restart_Glucose && conflictC >= 50 && lbd_fast * 0.8 > lbd_slow)
+             || (stop != NULL && *stop)){
                 // Reached bound on number of conflicts:
                 progress_estimate = progressEstimate();
                 cancelUntil(root_level);
@@ -694,22 +1125,39 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
 
             // New variable decision:
             stats.decisions++;
-            Var next = order.select(params.random_var_freq);
+            Lit next = pickBranchLit(params);
 
-            if (next == var_Undef){
+            if (next == lit_Undef){
                 // Model found:
                 model.growTo(nVars());
                 for (int i = 0; i < nVars(); i++) model[i] = value(i);
+                extendModel();
                 cancelUntil(root_level);
                 return l_True;
             }
 
-            check(assume(~Lit(next)));
+            check(assume(next));
         }
     }
 }
 
 
+// Return the 'x'th element of the Luby sequence scaled by powers of 'y' (1, 1, 2, 1, 1, 2, 4, ...
+// for y = 2).
+//
+static double luby(double y, int x)
+{
+    int size, seq;
+    for (size = 1, seq = 0; size < x+1; seq++, size = 2*size+1);
+    while (size-1 != x){
+        size = (size-1) >> 1;
+        seq--;
+        x = x % size;
+    }
+    return pow(y, seq);
+}
+
+
 // Return search-space coverage. Not extremely reliable.
 //
 double Solver::progressEstimate()
@@ -738,58 +1186,159 @@ void Solver::varRescaleActivity()
 void Solver::claRescaleActivity()
 {
     for (int i = 0; i < learnts.size(); i++)
-        learnts[i]->activity() *= 1e-20;
+        ca[learnts[i]].activity() *= 1e-20;
     cla_inc *= 1e-20;
 }
 
 
+//=================================================================================================
+// Clause sharing:
+
+
+void ClauseExchange::publish(int from, const vec<Lit>& c, int lbd)
+{
+    Ring&   r   = rings[from];
+    int64   h   = r.head.load(std::memory_order_relaxed);
+    int     len = c.size() + 2;
+    if (len > ring_size) return;
+
+    // Readers check 'reserved' after copying, so it must move before the old words are overwritten:
+    r.reserved.store(h + len, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    r.data[h & (ring_size-1)].store(lbd, std::memory_order_relaxed);
+    r.data[(h+1) & (ring_size-1)].store(c.size(), std::memory_order_relaxed);
+    for (int i = 0; i < c.size(); i++)
+        r.data[(h+2+i) & (ring_size-1)].store(index(c[i]), std::memory_order_relaxed);
+    r.head.store(h + len, std::memory_order_release);
+}
+
+
+void ClauseExchange::fetch(int to, vec<int>& out)
+{
+    for (int k = 0; k < n; k++){
+        if (k == to) continue;
+        Ring&   r    = rings[k];
+        int64&  pos  = read[to*n + k];
+        int64   head = r.head.load(std::memory_order_acquire);
+        if (head - pos > ring_size) pos = head;     // (overtaken: the clauses in between are lost)
+
+        int start = out.size();
+        for (int64 i = pos; i < head; i++)
+            out.push(r.data[i & (ring_size-1)].load(std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (r.reserved.load(std::memory_order_relaxed) - pos > ring_size)
+            out.shrink(out.size() - start);         // (overwritten while copied)
+        pos = head;
+    }
+}
+
+
+// Add the clauses in 'import_buf' (from 'ClauseExchange::fetch()') as learnt clauses. They are
+// implied by the problem clauses, which all the solvers of an exchange share. Must be at level 0;
+// the caller propagates.
+//
+void Solver::importClauses()
+{
+    assert(decisionLevel() == 0 && proof == NULL);
+    vec<Lit> ps;
+    for (int i = 0; i < import_buf.size() && ok; ){
+        int lbd = import_buf[i++], size = import_buf[i++];
+        bool skip = false;
+        ps.clear();
+        for (int k = 0; k < size; k++){
+            Lit p = toLit(import_buf[i++]);
+            if (skip || var(p) >= nVars() || eliminated[var(p)] || value(p) == l_True) { skip = true; continue; }
+            if (value(p) == l_Undef) ps.push(p);
+        }
+        if (skip) continue;
+
+        if (ps.size() == 0)
+            ok = false;
+        else if (ps.size() == 1)
+            check(enqueue(ps[0]));
+        else if (ps.size() == 2){
+            bin_watches[index(~ps[0])].push(ps[1]);
+            bin_watches[index(~ps[1])].push(ps[0]);
+            n_bin_clauses++;
+            stats.learnts_literals += 2;
+        }else{
+            CRef    cr = ca.alloc(ps, true);
+            Clause& c  = ca[cr];
+            claBumpActivity(c);
+            c.lbd() = lbd;
+            watches[index(~c[0])].push(Watcher(cr, c[1]));
+            watches[index(~c[1])].push(Watcher(cr, c[0]));
+            learnts.push(cr);
+            stats.learnts_literals += c.size();
+        }
+    }
+    import_buf.clear();
+}
+
+
+// Make the assumptions, one decision level each, from level 0. Returns FALSE (back at level 0 and
+// with 'conflict' set) if they contradict the clauses.
+//
+bool Solver::assumeAll(const vec<Lit>& assumps)
+{
+    assert(decisionLevel() == 0);
+    for (int i = 0; i < assumps.size(); i++){
+        Lit p = assumps[i];
+        assert(var(p) < nVars() && !eliminated[var(p)]);
+        if (!assume(p)){
+            if (reason[var(p)] != GClause_NULL){
+                analyzeFinal(reasonClause(var(p)), true);
+                conflict.push(~p);
+            }else{
+                assert(proof == NULL || unit_id[var(p)] != ClauseId_NULL);   // (this is the pre-condition above)
+                conflict.clear();
+                conflict.push(~p);
+                if (proof != NULL) conflict_id = unit_id[var(p)];
+            }
+            cancelUntil(0);
+            return false; }
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
+            analyzeFinal(confl), assert(conflict.size() > 0);
+            cancelUntil(0);
+            return false; }
+    }
+    assert(root_level == decisionLevel());
+    return true;
+}
+
+
 /*_________________________________________________________________________________________________
 |
-|  solve : (assumps : const vec<Lit>&)  ->  [bool]
+|  solveLimited : (assumps : const vec<Lit>&)  ->  [lbool]
 |  
 |  Description:
 |    Top-level solve. If using assumptions (non-empty 'assumps' vector), you must call
 |    'simplifyDB()' first to see that no top-level conflict is present (which would put the solver
-|    in an undefined state).
+|    in an undefined state). Returns 'l_Undef' if the search used up 'conflict_budget' or was
+|    stopped through 'stop'; the solver is left as after any other call and may be called again.
 |  
 |  Input:
 |    A list of assumptions (unit clauses coded as literals). Pre-condition: The assumptions must
 |    not contain both 'x' and '~x' for any variable 'x'.
 |________________________________________________________________________________________________@*/
-bool Solver::solve(const vec<Lit>& assumps)
+lbool Solver::solveLimited(const vec<Lit>& assumps)
 {
     simplifyDB();
-    if (!ok) return false;
+    if (!ok) return l_False;
 
     SearchParams    params(default_params);
     double  nof_conflicts = 100;
     double  nof_learnts   = nClauses() / 3;
     lbool   status        = l_Undef;
+    int     nof_restarts  = 0;
+    int64   confl_start   = stats.conflicts;
+    double  adjust_confl  = 100;        // (outside geometric restarts, the learnt limit grows as
+    double  adjust_inc    = 100;        //  if they were used: x1.1 after 100, 250, 475, ... conflicts)
 
     // Perform assumptions:
     root_level = assumps.size();
-    for (int i = 0; i < assumps.size(); i++){
-        Lit p = assumps[i];
-        assert(var(p) < nVars());
-        if (!assume(p)){
-            if (reason[var(p)] != NULL){
-                analyzeFinal(reason[var(p)], true);
-                conflict.push(~p);
-            }else{
-                assert(proof == NULL || unit_id[var(p)] != ClauseId_NULL);   // (this is the pre-condition above)
-                conflict.clear();
-                conflict.push(~p);
-                if (proof != NULL) conflict_id = unit_id[var(p)];
-            }
-            cancelUntil(0);
-            return false; }
-        Clause* confl = propagate();
-        if (confl != NULL){
-            analyzeFinal(confl), assert(conflict.size() > 0);
-            cancelUntil(0);
-            return false; }
-    }
-    assert(root_level == decisionLevel());
+    if (!assumeAll(assumps)) return l_False;
 
     // Search:
     if (verbosity >= 1){
@@ -815,13 +1364,38 @@ bool Solver::solve(const vec<Lit>& assumps)
                    progress_estimate*100);
             fflush(stdout);
         }
-        status = search((int)nof_conflicts, (int)nof_learnts, params);
-        nof_conflicts *= 1.5;
-        nof_learnts   *= 1.1;
+        if (params.restarts == restart_Geometric){
+            status = search((int)nof_conflicts, (int)nof_learnts, params);
+            nof_conflicts *= 1.5;
+            nof_learnts   *= 1.1;
+        }else{
+            int budget = (params.restarts == restart_Luby) ? (int)(luby(2, nof_restarts) * 100) : -1;
+            status = search(budget, (int)nof_learnts, params);
+            for (; stats.conflicts - confl_start >= adjust_confl; adjust_inc *= 1.5, adjust_confl += adjust_inc)
+                nof_learnts *= 1.1;
+        }
+        nof_restarts++;
+        if (status == l_Undef && ((conflict_budget >= 0 && stats.conflicts - confl_start >= conflict_budget)
+                               || (stop != NULL && *stop)))
+            break;
+
+        // Take in the clauses shared by the other solvers (at level 0, so the assumptions are redone):
+        if (status == l_Undef && exchange != NULL){
+            exchange->fetch(exchange_id, import_buf);
+            if (import_buf.size() > 0){
+                cancelUntil(0);
+                importClauses();
+                if (!ok || propagate() != CRef_Undef){
+                    ok = false;
+                    conflict.clear();
+                    return l_False; }
+                if (!assumeAll(assumps)) return l_False;
+            }
+        }
 
 if ((int)stats.conflicts >= effLimit) {
    cancelUntil(0);
-   return status == l_True;
+   return status;
 }
     }
     if (verbosity >= 1) {
@@ -830,7 +1404,7 @@ if ((int)stats.conflicts >= effLimit) {
     }
 
     cancelUntil(0);
-    return status == l_True;
+    return status;
 }
 
 void Solver::printStats()
@@ -20,6 +20,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #ifndef Solver_h
 #define Solver_h
 
+#include <atomic>
 #include "SolverTypes.h"
 #include "VarOrder.h"
 #include "Proof.h"
@@ -28,6 +29,35 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #define reportf(format, args...) ( printf(format , ## args), fflush(stdout) )
 
 
+//=================================================================================================
+// ClauseExchange -- learnt clauses passed between solvers on the same variables:
+
+
+// One ring of 'ring_size' words per solver, written only by its owner and read by all the others,
+// each with its own position in every ring (so there are no locks). A clause is stored as its LBD,
+// its size and its literals. A reader overtaken by the writer skips to the end of the ring; a
+// copy the writer overwrote meanwhile is dropped.
+class ClauseExchange {
+    static const int ring_size = 1 << 16;
+    struct Ring {
+        std::atomic<int>    data[ring_size];
+        std::atomic<int64>  head;           // Words written.
+        std::atomic<int64>  reserved;       // Words written or being written.
+        Ring() : head(0), reserved(0) { }
+    };
+    int                 n;
+    Ring*               rings;
+    vec<int64>          read;           // 'read[to*n + r]' is where reader 'to' is in ring 'r'.
+
+public:
+    ClauseExchange(int n_solvers) : n(n_solvers), rings(new Ring[n_solvers]) { read.growTo(n*n, 0); }
+   ~ClauseExchange() { delete [] rings; }
+
+    void publish(int from, const vec<Lit>& c, int lbd);
+    void fetch  (int to, vec<int>& out);     // Append the new clauses of the other solvers to 'out'.
+};
+
+
 //=================================================================================================
 // Solver -- the main class:
 
@@ -40,9 +70,18 @@ struct SolverStats {
 };
 
 
+enum RestartMode {
+    restart_Geometric,      // 100 conflicts, then x1.5 per restart (classic MiniSat)
+    restart_Luby,           // Luby sequence in units of 100 conflicts
+    restart_Glucose         // when the LBDs of recent learnt clauses rise above their long-term average
+};
+
 struct SearchParams {
-    double  var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
-    SearchParams(double v = 1, double c = 1, double r = 0) : var_decay(v), clause_decay(c), random_var_freq(r) { }
+    double      var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
+    RestartMode restarts;
+    bool        lbd_reduce;     // 'reduceDB()' keeps glue clauses (LBD <= 2) and ranks the rest by LBD instead of activity
+    SearchParams(double v = 1, double c = 1, double r = 0, RestartMode m = restart_Geometric, bool l = false)
+        : var_decay(v), clause_decay(c), random_var_freq(r), restarts(m), lbd_reduce(l) { }
 };
 
 
@@ -51,8 +90,9 @@ protected:
     // Solver state:
     //
     bool                ok;               // If FALSE, the constraints are already unsatisfiable. No part of the solver state may be used!
-    vec<Clause*>        clauses;          // List of problem clauses.
-    vec<Clause*>        learnts;          // List of learnt clauses.
+    ClauseAllocator     ca;               // Memory of all (non-binary) clauses; compacted when too much of it is wasted.
+    vec<CRef>           clauses;          // List of problem clauses.
+    vec<CRef>           learnts;          // List of learnt clauses.
     vec<ClauseId>       unit_id;          // 'unit_id[var]' is the clause ID for the unit literal 'var' or '~var' (if set at toplevel).
     double              cla_inc;          // Amount to bump next clause with.
     double              cla_decay;        // INVERSE decay factor for clause activity: stores 1/decay.
@@ -61,29 +101,42 @@ protected:
     double              var_inc;          // Amount to bump next variable with.
     double              var_decay;        // INVERSE decay factor for variable activity: stores 1/decay. Use negative value for static variable order.
     VarOrder            order;            // Keeps track of the decision variable order.
-
-    vec<vec<Clause*> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<char>           polarity;         // 'polarity[var]' is the sign of the next decision on 'var': the hint from 'setPolarity()', then (with 'phase_saving') the sign of its last value.
+    vec<char>           frozen;           // 'frozen[var]' is TRUE if 'eliminate()' must keep 'var' (it is used by later clauses or assumptions).
+    vec<char>           eliminated;       // 'eliminated[var]' is TRUE if 'eliminate()' removed 'var' from the problem.
+    vec<int>            elim_clauses;     // Clauses removed with eliminated variables, for 'extendModel()': literal indices (the eliminated one first), then the size.
+
+    vec<vec<Watcher> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Lit> >      bin_watches;      // 'bin_watches[lit]' is a list of literals implied by 'lit' through binary clauses (not stored as 'Clause's).
+    int                 n_bin_clauses;    // Number of binary clauses in 'bin_watches' (each is in two lists).
     vec<char>           assigns;          // The current assignments (lbool:s stored as char:s).
     vec<Lit>            trail;            // Assignment stack; stores all assigments made in the order they were made.
     vec<int>            trail_lim;        // Separator indices for different decision levels in 'trail[]'.
-    vec<Clause*>        reason;           // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none.
+    vec<GClause>        reason;           // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none. A binary clause is given by its other literal.
     vec<int>            level;            // 'level[var]' is the decision level at which assignment was made.
     vec<int>            trail_pos;        // 'trail_pos[var]' is the variable's position in 'trail[]'. This supersedes 'level[]' in some sense, and 'level[]' will probably be removed in future releases.
     int                 root_level;       // Level of first proper decision.
     int                 qhead;            // Head of queue (as index into the trail -- no more explicit propagation queue in MiniSat).
     int                 simpDB_assigns;   // Number of top-level assignments since last execution of 'simplifyDB()'.
     int64               simpDB_props;     // Remaining number of propagations that must be made before next execution of 'simplifyDB()'.
+    bool                lbd_reduce;       // Current 'SearchParams::lbd_reduce' (set by 'search()').
+    double              lbd_fast;         // Moving averages of the LBDs of learnt clauses over the last ~32 conflicts
+    double              lbd_slow;         // and the last ~16k conflicts; their ratio triggers Glucose restarts.
+    int64               lbd_count;        // Number of LBDs averaged so far (the averages start as plain means).
 
     // Temporaries (to reduce allocation overhead). Each variable is prefixed by the method in which is used:
     //
     vec<char>           analyze_seen;
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
-    Clause*             propagate_tmpbin;
-    Clause*             analyze_tmpbin;
+    vec<uint>           lbd_seen;         // 'lbd_seen[level]' is the stamp of the last 'computeLBD()' meeting 'level'.
+    uint                lbd_stamp;
+    CRef                propagate_tmpbin;
+    CRef                analyze_tmpbin;
     vec<Lit>            addUnit_tmp;
     vec<Lit>            addBinary_tmp;
     vec<Lit>            addTernary_tmp;
+    vec<int>            import_buf;
 
     // Main internal methods:
     //
@@ -91,15 +144,21 @@ protected:
     void        cancelUntil      (int level);
     void        record           (const vec<Lit>& clause);
 
-    void        analyze          (Clause* confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
+    void        analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel);    // (bt = backtrack)
     bool        analyze_removable(Lit p, uint min_level);                                 // (helper method for 'analyze()')
-    void        analyzeFinal     (Clause* confl, bool skip_first = false);
-    bool        enqueue          (Lit fact, Clause* from = NULL);
-    Clause*     propagate        ();
+    void        analyzeFinal     (CRef confl, bool skip_first = false);
+    bool        enqueue          (Lit fact, GClause from = GClause_NULL);
+    CRef        propagate        ();
+    int         computeLBD       (const Lit* ps, int size);
     void        reduceDB         ();
+    void        checkGarbage     ();
+    void        garbageCollect   ();
     Lit         pickBranchLit    (const SearchParams& params);
     lbool       search           (int nof_conflicts, int nof_learnts, const SearchParams& params);
     double      progressEstimate ();
+    void        extendModel      ();
+    bool        assumeAll        (const vec<Lit>& assumps);
+    void        importClauses    ();
 
     // Activity:
     //
@@ -114,11 +173,16 @@ protected:
 
     // Operations on clauses:
     //
-    void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true);
-    void     claBumpActivity (Clause* c) { if ( (c->activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
-    void     remove          (Clause* c, bool just_dealloc = false);
-    bool     locked          (const Clause* c) const { return reason[var((*c)[0])] == c; }
-    bool     simplify        (Clause* c) const;
+    void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true, int lbd = 0);
+    void     claBumpActivity (Clause& c) { if ( (c.activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
+    void     remove          (CRef cr);
+    bool     locked          (CRef cr) const { return reason[var(ca[cr][0])] == GClause_new(cr); }
+    CRef     reasonClause    (Var x) {      // (a binary reason is spelled out in 'analyze_tmpbin')
+        GClause r = reason[x];
+        if (!r.isLit()) return r.clause();
+        ca[analyze_tmpbin][0] = Lit(x, value(x) == l_False); ca[analyze_tmpbin][1] = r.lit();
+        return analyze_tmpbin; }
+    bool     simplify        (CRef cr) const;
 
     int      decisionLevel() const { return trail_lim.size(); }
 
@@ -129,30 +193,38 @@ public:
              , var_inc          (1)
              , var_decay        (1)
              , order            (assigns, activity)
+             , n_bin_clauses    (0)
              , qhead            (0)
              , simpDB_assigns   (0)
              , simpDB_props     (0)
+             , lbd_reduce       (false)
+             , lbd_fast         (0)
+             , lbd_slow         (0)
+             , lbd_count        (0)
+             , lbd_stamp        (0)
              , default_params   (SearchParams(0.95, 0.999, 0.02))
+             , phase_saving     (false)
              , expensive_ccmin  (2)
              , proof            (NULL)
              , verbosity        (0)
+             , conflict_budget  (-1)
+             , stop             (NULL)
+             , exchange         (NULL)
+             , exchange_id      (0)
+             , share_max_size   (8)
+             , share_max_lbd    (2)
              , progress_estimate(0)
              , conflict_id      (ClauseId_NULL)
              {
                 vec<Lit> dummy(2,lit_Undef);
-                propagate_tmpbin = Clause_new(false, dummy);
-                analyze_tmpbin   = Clause_new(false, dummy);
+                propagate_tmpbin = ca.alloc(dummy, false);
+                analyze_tmpbin   = ca.alloc(dummy, false);
                 addUnit_tmp   .growTo(1);
                 addBinary_tmp .growTo(2);
                 addTernary_tmp.growTo(3);
              }
 
-   ~Solver() {
-       for (int i = 0; i < learnts.size(); i++) remove(learnts[i], true);
-       for (int i = 0; i < clauses.size(); i++) if (clauses[i] != NULL) remove(clauses[i], true);
-       remove(propagate_tmpbin, true);
-       remove(analyze_tmpbin, true);
-    }
+   ~Solver() { }    // (all clauses go with 'ca')
 
     // Helpers: (semi-internal)
     //
@@ -162,7 +234,7 @@ public:
 //    lbool   modelValue(Lit p) const { return model[var(p)] ^ sign(p); }
 
     int     nAssigns() { return trail.size(); }
-    int     nClauses() { return clauses.size(); }
+    int     nClauses() { return clauses.size() + n_bin_clauses; }
     int     nLearnts() { return learnts.size(); }
 
     // Statistics: (read-only member variable)
@@ -172,9 +244,16 @@ public:
     // Mode of operation:
     //
     SearchParams    default_params;     // Restart frequency etc.
+    bool            phase_saving;       // Decide variables in the phase they last had (before backtracking). FALSE by default.
     int             expensive_ccmin;    // Controls conflict clause minimization. TRUE by default.
     Proof*          proof;              // Set this directly after constructing 'Solver' to enable proof logging. Initialized to NULL.
     int             verbosity;          // Verbosity level. 0=silent, 1=some progress report, 2=everything
+    int64           conflict_budget;    // If >= 0, 'solveLimited()' gives up after this many conflicts. -1 by default.
+    const std::atomic<bool>* stop;      // If set, 'solveLimited()' gives up as soon as '*stop' is TRUE (set by another thread). Initialized to NULL.
+    ClauseExchange* exchange;           // If set, short or glue learnt clauses go to the solvers sharing it (with the same variables), and theirs come in at restarts. Initialized to NULL.
+    int             exchange_id;        // The ring of this solver in 'exchange'.
+    int             share_max_size;     // Learnt clauses up to this size are shared... (8 by default)
+    int             share_max_lbd;      // ...and so are those with an LBD up to this. (2 by default)
 
     // Problem specification:
     //
@@ -185,12 +264,18 @@ public:
     void    addTernary(Lit p, Lit q, Lit r) { addTernary_tmp[0] = p; addTernary_tmp[1] = q; addTernary_tmp[2] = r; addClause(addTernary_tmp); }
     void    addClause (const vec<Lit>& ps , bool A = true)  { newClause(ps , false , ClauseId_NULL , A); }  
 	 // (used to be a difference between internal and external method...)
+    void    setPolarity(Var x, bool b)      { polarity[x] = !b; }   // Preferred value of 'x' when decided (FALSE by default).
+    void    setActivity(Var x, double a)    { if (a > activity[x]) { activity[x] = a; order.update(x); } }   // Raise the initial activity of 'x' (one conflict bumps by 1).
+    void    setRandomSeed(double s)         { order.seed(s); }   // Seed of the random decisions ('random_var_freq').
+    void    setFrozen  (Var x, bool b)      { frozen[x] = b; }      // Protect 'x' from 'eliminate()'.
 
     // Solving:
     //
     bool    okay() { return ok; }       // FALSE means solver is in an conflicting state (must never be used again!)
     void    simplifyDB();
-    bool    solve(const vec<Lit>& assumps);
+    bool    eliminate();                // Preprocessing; see 'Solver.cpp'.
+    lbool   solveLimited(const vec<Lit>& assumps);      // 'l_Undef' if 'conflict_budget' or 'stop' ended the search.
+    bool    solve(const vec<Lit>& assumps) { return solveLimited(assumps) == l_True; }
     bool    solve() { vec<Lit> tmp; return solve(tmp); }
 
     double      progress_estimate;  // Set by 'search()'.
@@ -82,59 +82,134 @@ const   int ClauseId_NULL = INT_MIN;
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 class Clause {
-    uint    size_learnt;
+    uint    header;     // size << 3 | reloced << 2 | has_id << 1 | learnt
     Lit     data[1];
-public:
-    // NOTE: This constructor cannot be used directly (doesn't allocate enough memory).
-    Clause(bool learnt, const vec<Lit>& ps, ClauseId id_ = ClauseId_NULL) {
-        size_learnt = (ps.size() << 1) | (int)learnt;
+
+    // NOTE: Clauses live in a 'ClauseAllocator', which reserves enough memory behind 'data'.
+    Clause(bool learnt, const vec<Lit>& ps, ClauseId id_) {
+        header = (ps.size() << 3) | ((int)(id_ != ClauseId_NULL) << 1) | (int)learnt;
         for (int i = 0; i < ps.size(); i++) data[i] = ps[i];
-        if (learnt) activity() = 0;
+        if (learnt) activity() = 0, lbd() = 0;
         if (id_ != ClauseId_NULL) id() = id_; }
+    friend class ClauseAllocator;
 
-    // -- use this function instead:
-    friend Clause* Clause_new(bool, const vec<Lit>&, ClauseId);
-
-    int       size        ()      const { return size_learnt >> 1; }
-    bool      learnt      ()      const { return size_learnt & 1; }
+public:
+    int       size        ()      const { return header >> 3; }
+    bool      learnt      ()      const { return header & 1; }
+    bool      hasId       ()      const { return header & 2; }
     Lit       operator [] (int i) const { return data[i]; }
     Lit&      operator [] (int i)       { return data[i]; }
     float&    activity    ()      const {
         void *p = const_cast<Lit*>(&data[size()]); return *((float *)p);
     } //              return *((float*)&data[size()]); }
-    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + (int)learnt()]); }
+    uint&     lbd         ()      const { return *((uint*)&data[size() + 1]); }     // (learnt only: literal block distance)
+    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + 2*(int)learnt()]); }
+    int       words       ()      const { return 1 + size() + 2*(int)learnt() + (int)hasId(); }
+
+    // Forwarding address, set while the clause arena is compacted:
+    bool      reloced     ()      const { return header & 4; }
+    uint      relocation  ()      const { return *((uint*)&data[0]); }
+    void      relocate    (uint c)      { header |= 4; *((uint*)&data[0]) = c; }
 };
 
-inline Clause* Clause_new(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
-    assert(sizeof(Lit)      == sizeof(uint));
-    assert(sizeof(float)    == sizeof(uint));
-    assert(sizeof(ClauseId) == sizeof(uint));
-    void*   mem = xmalloc<char>(sizeof(Clause) + sizeof(uint)*(ps.size() + (int)learnt + (int)(id != ClauseId_NULL)));
-    return new (mem) Clause(learnt, ps, id); }
+
+//=================================================================================================
+// ClauseAllocator -- a region of 32-bit words holding all clauses:
+
+
+// Clauses are referred to by their word offset in the region, which stays valid when the region
+// grows (and moves). Freed clauses are only counted as wasted; 'reloc()' copies the live ones into
+// a fresh region, leaving a forwarding address behind, so the owner can compact the region by
+// relocating every reference it keeps.
+typedef uint CRef;
+const CRef CRef_Undef = 0x7FFFFFFF;
+
+class ClauseAllocator {
+    uint*   memory;
+    uint    sz;
+    uint    cap;
+    uint    wasted_;
+
+    void    capacity(uint min_cap) {
+        if (cap >= min_cap) return;
+        while (cap < min_cap) cap += (cap >> 1) + 64;
+        memory = xrealloc(memory, cap); }
+
+public:
+    ClauseAllocator(uint start_cap = 1024) : memory(NULL), sz(0), cap(0), wasted_(0) { capacity(start_cap); }
+   ~ClauseAllocator() { xfree(memory); }
+
+    CRef alloc(const vec<Lit>& ps, bool learnt, ClauseId id = ClauseId_NULL) {
+        assert(sizeof(Lit)      == sizeof(uint));
+        assert(sizeof(float)    == sizeof(uint));
+        assert(sizeof(ClauseId) == sizeof(uint));
+        CRef cr = sz;
+        sz += 1 + ps.size() + 2*(int)learnt + (int)(id != ClauseId_NULL);
+        assert(sz < CRef_Undef);
+        capacity(sz);
+        new (&memory[cr]) Clause(learnt, ps, id);
+        return cr; }
+    void free(CRef cr) { wasted_ += (*this)[cr].words(); }
+
+    Clause&       operator [] (CRef cr)       { return (Clause&)memory[cr]; }
+    const Clause& operator [] (CRef cr) const { return (const Clause&)memory[cr]; }
+    uint size  () const { return sz; }
+    uint wasted() const { return wasted_; }
+
+    // Copy the clause 'cr' into 'to' (once) and update 'cr' to its new place:
+    void reloc(CRef& cr, ClauseAllocator& to) {
+        Clause& c = (*this)[cr];
+        if (c.reloced()){ cr = c.relocation(); return; }
+        CRef nr = to.sz;
+        to.sz += c.words();
+        to.capacity(to.sz);
+        memcpy(&to.memory[nr], &c, sizeof(uint) * c.words());
+        c.relocate(nr);
+        cr = nr; }
+
+    void moveTo(ClauseAllocator& to) {
+        xfree(to.memory);
+        to.memory = memory; to.sz = sz; to.cap = cap; to.wasted_ = wasted_;
+        memory = NULL; sz = cap = wasted_ = 0; }
+};
+
+
+//=================================================================================================
+// Watcher -- an entry of a watcher list:
+
+
+// 'blocker' is some literal of the clause other than the watched one. If it is true, the clause
+// is satisfied and 'propagate()' can skip it without touching the clause memory.
+struct Watcher {
+    CRef    cref;
+    Lit     blocker;
+    Watcher() : cref(CRef_Undef) {}
+    Watcher(CRef c, Lit p) : cref(c), blocker(p) {}
+};
 
 
 //=================================================================================================
 // GClause -- Generalize clause:
 
 
-// Either a pointer to a clause or a literal.
+// Either a reference to a clause or a literal.
 class GClause {
-    void*   data;
-    GClause(void* d) : data(d) {}
+    uint    data;
+    GClause(uint d) : data(d) {}
 public:
     friend GClause GClause_new(Lit p);
-    friend GClause GClause_new(Clause* c);
+    friend GClause GClause_new(CRef c);
 
-    bool        isLit    () const { return ((uintp)data & 1) == 1; }
-    Lit         lit      () const { return toLit(((intp)data) >> 1); }
-    Clause*     clause   () const { return (Clause*)data; }
+    bool        isLit    () const { return (data & 1) == 1; }
+    Lit         lit      () const { return toLit(data >> 1); }
+    CRef        clause   () const { return data >> 1; }
     bool        operator == (GClause c) const { return data == c.data; }
     bool        operator != (GClause c) const { return data != c.data; }
 };
-inline GClause GClause_new(Lit p)     { return GClause((void*)(((intp)index(p) << 1) + 1)); }
-inline GClause GClause_new(Clause* c) { assert(((uintp)c & 1) == 0); return GClause((void*)c); }
+inline GClause GClause_new(Lit p)  { return GClause(((uint)index(p) << 1) + 1); }
+inline GClause GClause_new(CRef c) { return GClause(c << 1); }
 
-#define GClause_NULL GClause_new((Clause*)NULL)
+#define GClause_NULL GClause_new(CRef_Undef)
 
 
 //=================================================================================================
@@ -49,6 +49,7 @@ public:
     inline void update(Var x);                  // Called when variable increased in activity.
     inline void undo(Var x);                    // Called when variable is unassigned and may be selected again.
     inline Var  select(double random_freq =.0); // Selects a new, unassigned variable (or 'var_Undef' if none exists).
+    void        seed  (double s) { random_seed = s; }   // Restart the random number generator (for diversification).
 };
 
 
@@ -11,6 +11,9 @@
 
 #include <cassert>
 #include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
 #include "Solver.h"
 
 using namespace std;
@@ -19,8 +22,8 @@ using namespace std;
 class SatSolver
 {
    public : 
-      SatSolver():_solver(0) { }
-      ~SatSolver() { if (_solver) delete _solver; }
+      SatSolver():_solver(0), _answer(0), _exchange(0), _soloConflicts(0) { }
+      ~SatSolver() { if (_solver) delete _solver; clearPortfolio(); }
 
       // Solver initialization and reset
       void initialize() {
@@ -29,13 +32,51 @@ class SatSolver
       }
       void reset() {
          if (_solver) delete _solver;
-         _solver = new Solver();
+         _solver = _answer = new Solver();
+         clearPortfolio();
          _assump.clear(); _curVar = 0;
       }
+      // Portfolio of "n" solvers (call before building the proof model;
+      // at most one per hardware thread). Every clause goes to all of them.
+      // A solve the first solver cannot settle within "soloConflicts"
+      // conflicts is raced by all of them, each with its own restart
+      // policy, decay and random decisions; the first answer wins and stops
+      // the others. As the solvers get the same variables and clauses in
+      // the same order, their short learnt clauses are exchanged too
+      void setPortfolio(unsigned n, int soloConflicts = 1000) {
+         assert(_solver->nClauses() == 0);
+         clearPortfolio();
+         _solver->exchange = 0;
+         if (n > maxPortfolio()) n = maxPortfolio();
+         if (n > 1) {
+            _exchange = new ClauseExchange(n);
+            _solver->exchange = _exchange;
+            _solver->exchange_id = 0;
+         }
+         for (unsigned k = 1; k < n; ++k) {
+            Solver* s = new Solver();
+            for (Var v = 0; v < _curVar; ++v) s->newVar();
+            diversify(s, k);
+            s->exchange = _exchange;
+            s->exchange_id = k;
+            _workers.push_back(s);
+         }
+         _soloConflicts = soloConflicts;
+      }
+
+      // Largest useful portfolio: one solver per hardware thread
+      static unsigned maxPortfolio() {
+         unsigned hw = thread::hardware_concurrency();
+         return hw ? hw : 1;
+      }
 
       // Constructing proof model
       // Return the Var ID of the new Var
-      inline Var newVar() { _solver->newVar(); return _curVar++; }
+      inline Var newVar() {
+         _solver->newVar();
+         for (size_t k = 0; k < _workers.size(); ++k) _workers[k]->newVar();
+         return _curVar++;
+      }
       // fa/fb = true if it is inverted
       void addAigCNF(Var vf, Var va, bool fa, Var vb, bool fb) {
          vec<Lit> lits;
@@ -43,11 +84,11 @@ class SatSolver
          Lit la = fa? ~Lit(va): Lit(va);
          Lit lb = fb? ~Lit(vb): Lit(vb);
          lits.push(la); lits.push(~lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
          lits.push(lb); lits.push(~lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
          lits.push(~la); lits.push(~lb); lits.push(lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
       }
       // fa/fb = true if it is inverted
       void addXorCNF(Var vf, Var va, bool fa, Var vb, bool fb) {
@@ -56,13 +97,13 @@ class SatSolver
          Lit la = fa? ~Lit(va): Lit(va);
          Lit lb = fb? ~Lit(vb): Lit(vb);
          lits.push(~la); lits.push( lb); lits.push( lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
          lits.push( la); lits.push(~lb); lits.push( lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
          lits.push( la); lits.push( lb); lits.push(~lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
          lits.push(~la); lits.push(~lb); lits.push(~lf);
-         _solver->addClause(lits); lits.clear();
+         addClause(lits); lits.clear();
       }
 
       // For incremental proof, use "assumeSolve()"
@@ -70,23 +111,127 @@ class SatSolver
       void assumeProperty(Var prop, bool val) {
          _assump.push(val? Lit(prop): ~Lit(prop));
       }
-      bool assumpSolve() { return _solver->solve(_assump); }
+      bool assumpSolve() { return raceSolve(); }
+      // Batched proof: can any of "props" be true under the assumptions?
+      // UNSAT proves all of them false. The OR is guarded by a fresh
+      // selector which is retired afterwards.
+      bool assumpSolveAny(const vector<Var>& props) {
+         Var sel = newVar();
+         vec<Lit> lits;
+         lits.push(~Lit(sel));
+         for (size_t i = 0; i < props.size(); ++i) lits.push(Lit(props[i]));
+         addClause(lits);
+         _assump.push(Lit(sel));
+         bool sat = raceSolve();
+         _assump.pop();
+         lits.clear(); lits.push(~Lit(sel));
+         addClause(lits);
+         return sat;
+      }
 
       // For one time proof, use "solve"
       void assertProperty(Var prop, bool val) {
-         _solver->addUnit(val? Lit(prop): ~Lit(prop));
+         vec<Lit> lits;
+         lits.push(val? Lit(prop): ~Lit(prop));
+         addClause(lits);
+      }
+      bool solve() { _answer = _solver; _solver->solve(); return _solver->okay(); }
+
+      // Search heuristics; see "SearchParams" in Solver.h (of the first
+      // solver only; the portfolio keeps its own)
+      void setSearchMode(RestartMode restarts, bool lbdReduce) {
+         _solver->default_params.restarts = restarts;
+         _solver->default_params.lbd_reduce = lbdReduce;
+      }
+      // With phase saving, a decision reuses the variable's value from
+      // before the last backtrack; "setPolarity" gives the value tried first
+      void setPhaseSaving(bool on) {
+         _solver->phase_saving = on;
+         for (size_t k = 0; k < _workers.size(); ++k) _workers[k]->phase_saving = on;
+      }
+      void setPolarity(Var v, bool val) {
+         _solver->setPolarity(v, val);
+         for (size_t k = 0; k < _workers.size(); ++k) _workers[k]->setPolarity(v, val);
+      }
+      // Initial VSIDS activity; a conflict bumps the variables in it by 1
+      void setActivity(Var v, double act) {
+         _solver->setActivity(v, act);
+         for (size_t k = 0; k < _workers.size(); ++k) _workers[k]->setActivity(v, act);
+      }
+
+      // Preprocessing: "eliminate" removes the unfrozen variables it can
+      // (bounded variable elimination) and the subsumed clauses; the model
+      // still gives them values. Freeze every variable a later clause or
+      // assumption may use. Return false if the proof model is unsatisfiable
+      void freeze(Var v) {
+         _solver->setFrozen(v, true);
+         for (size_t k = 0; k < _workers.size(); ++k) _workers[k]->setFrozen(v, true);
+      }
+      bool eliminate() {
+         bool ok = _solver->eliminate();
+         for (size_t k = 0; k < _workers.size(); ++k)
+            if (!_workers[k]->eliminate()) ok = false;
+         return ok;
       }
-      bool solve() { _solver->solve(); return _solver->okay(); }
 
       // Functions about Reporting
       // Return 1/0/-1; -1 means unknown value
       int getValue(Var v) const {
-         return (_solver->modelValue(v)==l_True?1:
-                (_solver->modelValue(v)==l_False?0:-1)); }
+         return (_answer->modelValue(v)==l_True?1:
+                (_answer->modelValue(v)==l_False?0:-1)); }
       void printStats() const { const_cast<Solver*>(_solver)->printStats(); }
 
    private : 
+      void addClause(vec<Lit>& lits) {
+         _solver->addClause(lits);
+         for (size_t k = 0; k < _workers.size(); ++k) _workers[k]->addClause(lits);
+      }
+      void clearPortfolio() {
+         for (size_t k = 0; k < _workers.size(); ++k) delete _workers[k];
+         _workers.clear();
+         if (_exchange) delete _exchange;
+         _exchange = 0;
+      }
+      // Worker k of the portfolio: its own restart policy, decay and random
+      // decisions, so that the solvers do not all take the same path
+      static void diversify(Solver* s, unsigned k) {
+         static const RestartMode restarts[3] = { restart_Glucose, restart_Geometric, restart_Luby };
+         static const double decay[3] = { 0.90, 0.99, 0.85 };
+         s->default_params = SearchParams(decay[k % 3], 0.999, 0.01 * (k % 5 + 1),
+                                          restarts[k % 3], restarts[k % 3] != restart_Geometric);
+         s->setRandomSeed(91648253 + 7919.0 * k);
+      }
+      bool raceSolve() {
+         _answer = _solver;
+         if (_workers.empty()) return _solver->solve(_assump);
+         // most calls are easy; thread start-up only pays off for hard ones
+         _solver->conflict_budget = _soloConflicts;
+         lbool r = _solver->solveLimited(_assump);
+         _solver->conflict_budget = -1;
+         if (r != l_Undef) return r == l_True;
+         atomic<bool> stop(false);
+         bool sat = false;
+         vector<thread> pool;
+         for (size_t k = 0; k <= _workers.size(); ++k) {
+            pool.push_back(thread([&, k] () {
+               Solver* s = k ? _workers[k - 1] : _solver;
+               s->stop = &stop;
+               lbool r = s->solveLimited(_assump);
+               if (r != l_Undef && !stop.exchange(true)) {
+                  _answer = s; sat = (r == l_True);
+               }
+               s->stop = 0;
+            }));
+         }
+         for (size_t k = 0; k < pool.size(); ++k) pool[k].join();
+         return sat;
+      }
+
       Solver           *_solver;    // Pointer to a Minisat solver
+      Solver           *_answer;    // The solver whose model "getValue" reads
+      vector<Solver*>   _workers;   // The rest of the portfolio
+      ClauseExchange   *_exchange;  // Their shared learnt clauses
+      int               _soloConflicts;
       Var               _curVar;    // Variable currently
       vec<Lit>          _assump;    // Assumption List for assumption solve
 };
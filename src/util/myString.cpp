@@ -78,6 +78,22 @@ myStr2Int(const string& str, int& num)
    return valid;
 }
 
+// Convert string "str" to size_t "num". Return false if str is not an
+// unsigned number or does not fit
+bool
+myStr2Size(const string& str, size_t& num)
+{
+   num = 0;
+   if (str.empty()) return false;
+   for (size_t i = 0; i < str.size(); ++i) {
+      if (!isdigit(str[i])) return false;
+      size_t d = size_t(str[i] - '0');
+      if (num > (size_t(-1) - d) / 10) return false;
+      num = num * 10 + d;
+   }
+   return true;
+}
+
 // Valid var name is ---
 // 1. starts with [a-zA-Z_]
 // 2. others, can only be [a-zA-Z0-9_]
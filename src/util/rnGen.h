@@ -26,5 +26,55 @@ class RandomNumGen
       }
 };
 
+// xoshiro256** generator giving full 64-bit words, seeded by splitmix64.
+// Unlike RandomNumGen it keeps its own state, so each thread can own one;
+// use "stream" (or jump()) to get non-overlapping sequences of one seed.
+class RandomNumGen64
+{
+   public:
+      RandomNumGen64(size_t seed = 0, unsigned stream = 0) { setSeed(seed, stream); }
+
+      void setSeed(size_t seed, unsigned stream = 0) {
+         for (unsigned i = 0; i < 4; ++i) _s[i] = splitMix64(seed);
+         for (unsigned i = 0; i < stream; ++i) jump();
+      }
+      size_t operator() () {
+         const size_t result = rotl(_s[1] * 5, 7) * 9;
+         const size_t t = _s[1] << 17;
+         _s[2] ^= _s[0]; _s[3] ^= _s[1];
+         _s[1] ^= _s[2]; _s[0] ^= _s[3];
+         _s[2] ^= t;     _s[3] = rotl(_s[3], 45);
+         return result;
+      }
+      void fill(size_t* p, size_t n) { for (size_t i = 0; i < n; ++i) p[i] = (*this)(); }
+      template<class T>
+      void fill(T& v) { if (!v.empty()) fill(&v[0], v.size()); }
+
+      // Advance 2^128 steps; 2^128 jumps give non-overlapping streams
+      void jump() {
+         static const size_t J[4] = { 0x180ec6d33cfd0abaUL, 0xd5a61266f0c9392cUL,
+                                      0xa9582618e03fc9aaUL, 0x39abdc4529b1661cUL };
+         size_t s[4] = { 0, 0, 0, 0 };
+         for (unsigned i = 0; i < 4; ++i)
+            for (unsigned b = 0; b < 64; ++b) {
+               if (J[i] & ((size_t)1 << b))
+                  for (unsigned k = 0; k < 4; ++k) s[k] ^= _s[k];
+               (*this)();
+            }
+         for (unsigned k = 0; k < 4; ++k) _s[k] = s[k];
+      }
+
+   private:
+      size_t _s[4];
+
+      static size_t rotl(const size_t x, int k) { return (x << k) | (x >> (64 - k)); }
+      static size_t splitMix64(size_t& x) {
+         size_t z = (x += 0x9e3779b97f4a7c15UL);
+         z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+         z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+         return z ^ (z >> 31);
+      }
+};
+
 #endif // RN_GEN_H
 
@@ -24,6 +24,7 @@ extern int myStrNCmp(const string& s1, const string& s2, unsigned n);
 extern size_t myStrGetTok(const string& str, string& tok, size_t pos = 0,
                           const char del = ' ');
 extern bool myStr2Int(const string& str, int& num);
+extern bool myStr2Size(const string& str, size_t& num);
 extern bool isValidVarName(const string& str);
 
 // In myGetChar.cpp